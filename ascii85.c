@@ -29,19 +29,130 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(ASCII85_NO_SIMD)
+#include <immintrin.h>
+#define ASCII85_SIMD 1
+#endif
 
 enum ascii85_errs_e
 {
     ascii85_err_out_buf_too_small = -255,
     ascii85_err_in_buf_too_large,
     ascii85_err_bad_decode_char,
-    ascii85_err_decode_overflow
+    ascii85_err_decode_overflow,
+    ascii85_err_bad_in_length,
+    ascii85_err_crc_mismatch,
+    ascii85_err_out_of_memory
+};
+
+struct ascii85_wrap
+{
+    int32_t line_width; // line break after this many chars, 0 for none
+    bool framed;        // enclose the output in "<~" and "~>"
+    int32_t column;     // state: chars in the current line
+    bool started;       // state: "<~" has been written
+};
+
+struct base85_variant
+{
+    const char *name;
+    const char *alphabet;     // digits 0..84, NULL for the contiguous range starting at base_char
+    uint8_t base_char;
+    const int32_t *decode_lut; // char -> digit or -1, for alphabets only
+    bool zero_as_z;           // 'z' for an all-zero group
+    bool spaces_as_y;         // 'y' for a group of four spaces
+    int32_t (*encode) (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
+    int32_t (*decode) (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+    int32_t (*decode_avx2) (const char *inp, int32_t in_length, uint8_t *outp);
 };
 
+extern const struct base85_variant base85_ascii85;
+extern const struct base85_variant base85_z85;
+extern const struct base85_variant base85_rfc1924;
+extern const struct base85_variant base85_btoa;
+
 int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
 
 int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
 
+int32_t encode_z85 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
+
+int32_t decode_z85 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int32_t encode_rfc1924 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
+
+int32_t decode_rfc1924 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int32_t encode_btoa (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
+
+int32_t decode_btoa (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int32_t encode_ascii85_crc (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length);
+
+int32_t decode_ascii85_crc (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length);
+
+int64_t ascii85_encoded_length (const uint8_t *inp, int64_t in_length);
+
+int64_t ascii85_decoded_length (const char *inp, int64_t in_length, int64_t *inplace_headroom);
+
+int64_t decode_ascii85_inplace (char *buf, int64_t in_length, int64_t buf_size);
+
+int64_t base85_complete_groups (const struct base85_variant *v, const char *inp, int64_t in_length);
+
+int64_t ascii85_wrap_max_length (const struct ascii85_wrap *wrap, int64_t in_length, bool final);
+
+int64_t encode_ascii85_wrap (struct ascii85_wrap *wrap, const uint8_t *inp, int64_t in_length, char *outp,
+                             int64_t out_max_length, bool final);
+
+int64_t decode_ascii85_ws (const char *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length);
+
+struct ascii85_framer
+{
+    uint8_t *buf;
+    size_t size;
+    size_t headroom;     // in front of the receive area, for frames that decode larger than they are
+    size_t start;        // start of the current frame
+    size_t scan;         // next byte to scan for a delimiter
+    size_t end;          // end of received data
+    bool skipping;       // current frame was too large, drop it up to the next delimiter
+    bool check_crc;      // frames end with a CRC32C trailer (encode_ascii85_crc), verify and strip it
+    int64_t frame_groups;   // state of the current frame: complete groups ..
+    int64_t frame_nonz;     // .. chars not being 'z' ..
+    int64_t frame_headroom; // .. and headroom needed to decode it in place
+    void (*on_frame) (void *user, uint8_t *data, int64_t length);
+    void *user;
+};
+
+int ascii85_framer_init (struct ascii85_framer *framer, size_t max_frame_length,
+                         void (*on_frame) (void *user, uint8_t *data, int64_t length), void *user);
+
+void ascii85_framer_free (struct ascii85_framer *framer);
+
+ssize_t ascii85_framer_read (struct ascii85_framer *framer, int fd);
+
+int64_t base85_encode_mt (const struct base85_variant *v, const uint8_t *inp, int64_t in_length, char *outp,
+                          int64_t out_max_length, unsigned int threads);
+
+int64_t base85_decode_mt (const struct base85_variant *v, const char *inp, int64_t in_length, uint8_t *outp,
+                          int64_t out_max_length, unsigned int threads);
+
+int64_t encode_ascii85_mt (const uint8_t *inp, int64_t in_length, char *outp, int64_t out_max_length,
+                           unsigned int threads);
+
+int64_t decode_ascii85_mt (const char *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length,
+                           unsigned int threads);
+
 // From Wikipedia re: Ascii85 length...
 // Adobe adopted the basic btoa encoding, but with slight changes, and gave it the name Ascii85.
 // The characters used are the ASCII characters 33 (!) through 117 (u) inclusive (to represent
@@ -62,7 +173,8 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
 // that the high order bits are preserved (the zero padding in the binary gives enough room so
 // that a small addition is trapped and there is no "carry" to the high bits).
 
-// NOTE: ths implementation does not ignore white space!
+// NOTE: ths implementation does not ignore white space! Use decode_ascii85_ws for line-wrapped
+// and/or <~ ~> framed input (PDF, PostScript).
 //
 // The motivation for this implementation is as a binary message wrapper for serial
 // communication; in that application, white space is used for message framing.
@@ -71,6 +183,7 @@ static const uint8_t base_char = 33u; // '!' -- note that (85 + 33) < 128
 
 static const int32_t ascii85_in_length_max = 65536;
 static const bool ascii85_check_decode_chars = true;
+static bool ascii85_simd_enabled = true; // cleared to measure the scalar paths
 #define ENDECODE_NUL_AS_Z 1
 
 #if 0
@@ -80,48 +193,336 @@ static inline bool ascii85_char_ok (uint8_t c)
 }
 #endif
 
-static inline bool ascii85_char_ng (uint8_t c)
+// The en/decoders below are written once against a variant description (alphabet, decode
+// table, special groups). Every variant gets its own non-inlined entry points which call the
+// always_inline bodies with a pointer to a static const variant, so the compiler specializes
+// each of them like hand written code: no alphabet lookups at runtime for Ascii85/btoa, and
+// the decode table address is a constant for Z85/RFC 1924.
+
+static inline bool base85_char_ng (const struct base85_variant *v, uint8_t c)
+{
+    if (v->alphabet == NULL)
+    {
+        return ((c < v->base_char) || (c > (v->base_char + 84u)));
+    }
+    return (v->decode_lut[c] < 0);
+}
+
+static inline uint32_t base85_digit (const struct base85_variant *v, uint8_t c)
+{
+    return (v->alphabet == NULL) ? (uint32_t )(c - v->base_char) : (uint32_t )v->decode_lut[c];
+}
+
+static inline char base85_char (const struct base85_variant *v, uint32_t digit)
+{
+    return (v->alphabet == NULL) ? (char )(digit + v->base_char) : v->alphabet[digit];
+}
+
+static inline bool base85_special (const struct base85_variant *v, uint8_t c)
+{
+    return (v->zero_as_z && ((uint8_t )'z' == c)) || (v->spaces_as_y && ((uint8_t )'y' == c));
+}
+
+static void base85_init_lut (int32_t lut[256], const char *alphabet)
+{
+    int i;
+
+    for (i = 0; i < 256; i++)
+    {
+        lut[i] = -1;
+    }
+    for (i = 0; i < 85; i++)
+    {
+        lut[(uint8_t )alphabet[i]] = i;
+    }
+}
+
+static int32_t z85_decode_lut[256];
+static int32_t rfc1924_decode_lut[256];
+static pthread_once_t base85_lut_once = PTHREAD_ONCE_INIT;
+
+static void base85_init_luts (void)
+{
+    base85_init_lut(z85_decode_lut, base85_z85.alphabet);
+    base85_init_lut(rfc1924_decode_lut, base85_rfc1924.alphabet);
+}
+
+static inline bool ascii85_cpu_has_avx2 (void)
+{
+#ifdef ASCII85_SIMD
+    return ascii85_simd_enabled && __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static inline bool ascii85_cpu_has_sse42 (void)
+{
+#ifdef ASCII85_SIMD
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78): the SSE4.2 crc32 instruction if
+// available (inline asm, so no target attributes are needed in the fused en/decode loops),
+// slicing-by-8 with generated tables otherwise.
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void crc32c_init_table (void)
+{
+    uint32_t i, j, crc;
+
+    for (i = 0; i < 256u; i++)
+    {
+        crc = i;
+        for (j = 0; j < 8u; j++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1u) ? 0x82F63B78u : 0u);
+        }
+        crc32c_table[0][i] = crc;
+    }
+    for (i = 0; i < 256u; i++)
+    {
+        for (j = 1; j < 8u; j++)
+        {
+            crc32c_table[j][i] = (crc32c_table[j - 1][i] >> 8) ^ crc32c_table[0][crc32c_table[j - 1][i] & 0xFFu];
+        }
+    }
+}
+
+static inline uint32_t crc32c_sw (uint32_t crc, const uint8_t *data, size_t length)
+{
+    while (length >= 8)
+    {
+        uint32_t lo = crc ^ ((uint32_t )data[0] | ((uint32_t )data[1] << 8) | ((uint32_t )data[2] << 16)
+                             | ((uint32_t )data[3] << 24));
+
+        crc = crc32c_table[7][lo & 0xFFu] ^ crc32c_table[6][(lo >> 8) & 0xFFu]
+            ^ crc32c_table[5][(lo >> 16) & 0xFFu] ^ crc32c_table[4][lo >> 24]
+            ^ crc32c_table[3][data[4]] ^ crc32c_table[2][data[5]]
+            ^ crc32c_table[1][data[6]] ^ crc32c_table[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length-- > 0)
+    {
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *data++) & 0xFFu];
+    }
+    return crc;
+}
+
+#ifdef ASCII85_SIMD
+static inline uint32_t crc32c_hw (uint32_t crc, const uint8_t *data, size_t length)
+{
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+
+    while (length >= 8)
+    {
+        uint64_t v;
+
+        memcpy(&v, data, sizeof(v));
+        __asm__ ("crc32q %1, %0" : "+r" (crc64) : "rm" (v));
+        data += 8;
+        length -= 8;
+    }
+    crc = (uint32_t )crc64;
+#endif
+    while (length >= 4)
+    {
+        uint32_t v;
+
+        memcpy(&v, data, sizeof(v));
+        __asm__ ("crc32l %1, %0" : "+r" (crc) : "rm" (v));
+        data += 4;
+        length -= 4;
+    }
+    while (length-- > 0)
+    {
+        __asm__ ("crc32b %1, %0" : "+r" (crc) : "rm" (*data));
+        data++;
+    }
+    return crc;
+}
+#endif
+
+static void crc32c_init (void)
 {
-    return ((c < 33u) || (c > 117u));
+    pthread_once(&crc32c_once, crc32c_init_table);
 }
 
 /*!
- * @brief encode_ascii85: encode binary input into Ascii85
- * @param[in] inp pointer to a buffer of unsigned bytes 
- * @param[in] in_length the number of bytes at inp to encode
- * @param[in] outp pointer to a buffer for the encoded data as c-string
- * @param[in] out_max_length available space at outp in bytes; must be >= 5 * ceiling(in_length/4)
- * @return number of bytes in the encoded value at outp if non-negative; error code from
- * ascii85_errs_e if negative
- * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ * @brief crc32c_update: continue a CRC32C, start with crc32c_update(0, ...); call crc32c_init first
  */
-int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+static inline uint32_t crc32c_update (uint32_t crc, const uint8_t *data, size_t length)
+{
+    crc = ~crc;
+#ifdef ASCII85_SIMD
+    if (ascii85_cpu_has_sse42())
+    {
+        return ~crc32c_hw(crc, data, length);
+    }
+#endif
+    return ~crc32c_sw(crc, data, length);
+}
+
+#ifdef ASCII85_SIMD
+/*!
+ * @brief base85_decode_avx2: decode blocks of 8 groups (40 chars -> 32 bytes) at once
+ * @param[in] v variant, must be a pointer to a static const variant
+ * @param[in] inp pointer to encoded input, at least 40 chars available
+ * @param[in] in_length the number of chars available at inp
+ * @param[in] outp pointer to a buffer with room for 4 bytes per decoded group
+ * @return number of groups decoded; stops in front of the first special, bad char or overflowing
+ * group, which is left to the scalar path (that one also reports errors)
+ * @par For contiguous alphabets each block is range checked with two overlapping 32 byte
+ * compares and the digits of all eight groups are gathered into 32-bit lanes; table alphabets
+ * gather every digit from the decode table instead. The digits are evaluated by Horner's scheme
+ * with 32-bit multiplies and overflowing groups are detected for all lanes at once before the
+ * final multiply.
+ */
+static inline __attribute__((always_inline, target("avx2")))
+int32_t base85_decode_avx2 (const struct base85_variant *v, const char *inp, int32_t in_length, uint8_t *outp)
+{
+    const __m256i group_idx = _mm256_setr_epi32(0, 5, 10, 15, 20, 25, 30, 35);
+    const __m256i lane_idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i bswap32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i dig0123_lo = _mm256_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1,
+                                                0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1);
+    const __m256i dig0123_hi = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 11, 12, 13, 14,
+                                                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 11, 12, 13, 14);
+    const __m256i dig4_lo = _mm256_setr_epi8(-1, -1, -1, 4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1,
+                                             -1, -1, -1, 4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1);
+    const __m256i dig4_hi = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 15,
+                                             -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 15);
+    const __m256i v85 = _mm256_set1_epi32(85);
+    const __m256i v_byte = _mm256_set1_epi32(0xFF);
+    const __m256i v_one = _mm256_set1_epi32(1);
+    const __m256i v_mul_max = _mm256_set1_epi32((int )(UINT32_MAX / 85u)); // 50,529,027
+    int32_t groups = 0;
+
+    while ((in_length - (groups * 5)) >= 40)
+    {
+        const char *blk = &inp[groups * 5];
+        __m256i d0, d1, d2, d3, d4, chunk, over;
+        uint32_t over_lanes;
+        int lanes;
+
+        if (v->alphabet == NULL)
+        {
+            const __m256i char_lo = _mm256_set1_epi8((char )(v->base_char - 1));
+            const __m256i char_hi = _mm256_set1_epi8((char )(v->base_char + 85)); // < 128, bytes >= 128 are negative
+            const __m256i digit_off = _mm256_set1_epi8((char )v->base_char);
+            __m256i a = _mm256_loadu_si256((const __m256i *)blk);
+            __m256i b = _mm256_loadu_si256((const __m256i *)(blk + 8));
+            __m256i ok_a = _mm256_and_si256(_mm256_cmpgt_epi8(a, char_lo), _mm256_cmpgt_epi8(char_hi, a));
+            __m256i ok_b = _mm256_and_si256(_mm256_cmpgt_epi8(b, char_lo), _mm256_cmpgt_epi8(char_hi, b));
+            uint64_t bad = ((uint64_t )(uint32_t )~_mm256_movemask_epi8(ok_a))
+                         | (((uint64_t )(uint32_t )~_mm256_movemask_epi8(ok_b)) << 8u);
+            // 4 groups (20 chars) per 128 bit lane, from two overlapping loads: digits 0..3 of each
+            // group into one dword, digit 4 as top byte of a second one. Shuffles, not gathers:
+            // those are slow on a lot of CPUs (microcode mitigations).
+            __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)blk)),
+                                                 _mm_loadu_si128((const __m128i *)(blk + 20)), 1);
+            __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(blk + 4))),
+                                                 _mm_loadu_si128((const __m128i *)(blk + 24)), 1);
+            __m256i d0123 = _mm256_sub_epi8(_mm256_or_si256(_mm256_shuffle_epi8(lo, dig0123_lo),
+                                                            _mm256_shuffle_epi8(hi, dig0123_hi)), digit_off);
+
+            lanes = (bad != 0u) ? (__builtin_ctzll(bad) / 5) : 8;
+            d4 = _mm256_srli_epi32(_mm256_sub_epi8(_mm256_or_si256(_mm256_shuffle_epi8(lo, dig4_lo),
+                                                                   _mm256_shuffle_epi8(hi, dig4_hi)), digit_off), 24);
+            d0 = _mm256_and_si256(d0123, v_byte);
+            d1 = _mm256_and_si256(_mm256_srli_epi32(d0123, 8), v_byte);
+            d2 = _mm256_and_si256(_mm256_srli_epi32(d0123, 16), v_byte);
+            d3 = _mm256_srli_epi32(d0123, 24);
+        }
+        else
+        {
+            __m256i c0123 = _mm256_i32gather_epi32((const int *)blk, group_idx, 1);
+            __m256i bad;
+            uint32_t bad_lanes;
+
+            d0 = _mm256_i32gather_epi32((const int *)v->decode_lut, _mm256_and_si256(c0123, v_byte), 4);
+            d1 = _mm256_i32gather_epi32((const int *)v->decode_lut, _mm256_and_si256(_mm256_srli_epi32(c0123, 8), v_byte), 4);
+            d2 = _mm256_i32gather_epi32((const int *)v->decode_lut, _mm256_and_si256(_mm256_srli_epi32(c0123, 16), v_byte), 4);
+            d3 = _mm256_i32gather_epi32((const int *)v->decode_lut, _mm256_srli_epi32(c0123, 24), 4);
+            d4 = _mm256_i32gather_epi32((const int *)v->decode_lut,
+                                        _mm256_srli_epi32(_mm256_i32gather_epi32((const int *)(blk + 1), group_idx, 1), 24), 4);
+            // invalid chars map to -1
+            bad = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3)), d4);
+            bad_lanes = (uint32_t )_mm256_movemask_ps(_mm256_castsi256_ps(bad));
+            lanes = (bad_lanes != 0u) ? __builtin_ctz(bad_lanes) : 8;
+        }
+
+        chunk = _mm256_add_epi32(_mm256_mullo_epi32(d0, v85), d1);
+        chunk = _mm256_add_epi32(_mm256_mullo_epi32(chunk, v85), d2);
+        chunk = _mm256_add_epi32(_mm256_mullo_epi32(chunk, v85), d3);
+        // chunk * 85 + d4 overflows iff chunk > UINT32_MAX/85 or (chunk == UINT32_MAX/85 and d4 > 0)
+        over = _mm256_cmpgt_epi32(_mm256_add_epi32(chunk, _mm256_min_epu32(d4, v_one)), v_mul_max);
+        over_lanes = (uint32_t )_mm256_movemask_ps(_mm256_castsi256_ps(over)) & ((1u << lanes) - 1u);
+
+        if (over_lanes != 0u)
+        {
+            lanes = __builtin_ctz(over_lanes);
+        }
+
+        chunk = _mm256_shuffle_epi8(_mm256_add_epi32(_mm256_mullo_epi32(chunk, v85), d4), bswap32);
+        if (lanes == 8)
+        {
+            _mm256_storeu_si256((__m256i *)&outp[groups * 4], chunk);
+            groups += 8;
+        }
+        else
+        {
+            _mm256_maskstore_epi32((int *)&outp[groups * 4], _mm256_cmpgt_epi32(_mm256_set1_epi32(lanes), lane_idx), chunk);
+            groups += lanes;
+            break; // let the scalar path handle the special or bad group
+        }
+    }
+
+    return groups;
+}
+#endif
+
+/*!
+ * @brief base85_encode: encode binary input into base85 of the given variant
+ * @param[in] v variant, must be a pointer to a static const variant
+ * @param[in,out] crc if not NULL, the CRC32C is continued over the input inside the loop
+ * @par see encode_ascii85 for the other parameters
+ */
+static inline __attribute__((always_inline))
+int32_t base85_encode (const struct base85_variant *v, const uint8_t *inp, int32_t in_length, char *outp,
+                       int32_t out_max_length, uint32_t *crc)
 {
-    // Note that (in_length + 3) below may overflow, but this is inconsequental
-    // since ascii85_in_length_max is < (INT32_MAX - 3), and we check in_length before
-    // using the calculated out_length.
+    // The output is at most 5 * ceiling(in_length/4) chars, fewer with 'z'/'y' groups; the
+    // space left is checked per group, so a buffer of ascii85_encoded_length chars is enough.
     //
-    int32_t out_length = (((in_length + 3) / 4) * 5); // ceiling
+    int32_t out_length = 0;
 
     if (in_length > ascii85_in_length_max)
     {
         out_length = (int32_t )ascii85_err_in_buf_too_large;
     }
-    else if (out_length > out_max_length)
-    {
-        out_length = (int32_t )ascii85_err_out_buf_too_small;
-    }
     else
     {
         int32_t in_rover = 0;
 
-        out_length = 0; // we know we can increment by 5 * ceiling(in_length/4)
-
         while (in_rover < in_length)
         {
             uint32_t chunk;
             int32_t chunk_len = in_length - in_rover;
 
+            if (crc != NULL)
+            {
+                *crc = crc32c_update(*crc, &inp[in_rover], (chunk_len >= 4) ? 4 : chunk_len);
+            }
+
             if (chunk_len >= 4)
             {
                 chunk  = (((uint32_t )inp[in_rover++]) << 24u);
@@ -137,33 +538,55 @@ int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, char *outp, int32
                 chunk |= ((in_rover < in_length) ? (((uint32_t )inp[in_rover++])       ) : 0u);
             }
 
-#ifdef ENDECODE_NUL_AS_Z
-            if (/*lint -e{506} -e{774}*/ (0u == chunk) && (chunk_len >= 4))
+            if (/*lint -e{506} -e{774}*/ v->zero_as_z && (0u == chunk) && (chunk_len >= 4))
             {
+                if (out_length >= out_max_length)
+                {
+                    out_length = (int32_t )ascii85_err_out_buf_too_small;
+                    break; // leave while loop early to report error
+                }
                 outp[out_length++] = (uint8_t )'z';
             }
+            else if (/*lint -e{506} -e{774}*/ v->spaces_as_y && (0x20202020u == chunk) && (chunk_len >= 4))
+            {
+                if (out_length >= out_max_length)
+                {
+                    out_length = (int32_t )ascii85_err_out_buf_too_small;
+                    break; // leave while loop early to report error
+                }
+                outp[out_length++] = (uint8_t )'y';
+            }
             else
-#endif
             {
-                outp[out_length + 4] = (chunk % 85u) + base_char;
+                char group[5];
+                int32_t group_len = (chunk_len >= 4) ? 5 : (chunk_len + 1); // see note above re: Ascii85 length
+
+                if ((out_max_length - out_length) < group_len)
+                {
+                    out_length = (int32_t )ascii85_err_out_buf_too_small;
+                    break; // leave while loop early to report error
+                }
+
+                group[4] = base85_char(v, chunk % 85u);
                 chunk /= 85u;
-                outp[out_length + 3] = (chunk % 85u) + base_char;
+                group[3] = base85_char(v, chunk % 85u);
                 chunk /= 85u;
-                outp[out_length + 2] = (chunk % 85u) + base_char;
+                group[2] = base85_char(v, chunk % 85u);
                 chunk /= 85u;
-                outp[out_length + 1] = (chunk % 85u) + base_char;
+                group[1] = base85_char(v, chunk % 85u);
                 chunk /= 85u;
-                outp[out_length    ] = (uint8_t )chunk + base_char;
+                group[0] = base85_char(v, chunk);
                 // we don't need (chunk % 85u) on the last line since (((((2^32 - 1) / 85) / 85) / 85) / 85) = 82.278
 
-                if (chunk_len >= 4)
+                if (5 == group_len)
                 {
-                    out_length += 5;
+                    memcpy(&outp[out_length], group, 5);
                 }
                 else
                 {
-                    out_length += (chunk_len + 1); // see note above re: Ascii85 length
+                    memcpy(&outp[out_length], group, group_len); // the tail
                 }
+                out_length += group_len;
             }
         }
     }
@@ -172,23 +595,20 @@ int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, char *outp, int32
 }
 
 /*!
- * @brief decode_ascii85: decode Ascii85 input to binary output
- * @param[in] inp pointer to a buffer of Ascii85 encoded c-string
- * @param[in] in_length the number of bytes at inp to decode
- * @param[in] outp pointer to a buffer for the decoded data
- * @param[in] out_max_length available space at outp in bytes; must be >= 4 * ceiling(in_length/5)
- * @return number of bytes in the decoded value at outp if non-negative; error code from
- * ascii85_errs_e if negative
- * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small, 
- * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ * @brief base85_decode: decode base85 input of the given variant to binary output
+ * @param[in] v variant, must be a pointer to a static const variant
+ * @param[in,out] crc if not NULL, the CRC32C is continued over the output inside the loop,
+ * except for the last 4 bytes (the trailer written by encode_ascii85_crc)
+ * @par see decode_ascii85 for the other parameters
  */
-int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+static inline __attribute__((always_inline))
+int32_t base85_decode (const struct base85_variant *v, const char *inp, int32_t in_length, uint8_t *outp,
+                       int32_t out_max_length, uint32_t *crc)
 {
-    // Note that (in_length + 4) below may overflow, but this is inconsequental
-    // since ascii85_in_length_max is < (INT32_MAX - 4), and we check in_length before
-    // using the calculated out_length.
+    // The output is at least this long, longer with 'z'/'y' groups; the space left is checked
+    // per group, so a buffer of ascii85_decoded_length bytes is enough.
     //
-    int32_t out_length = (((in_length + 4) / 5) * 4); // ceiling
+    int32_t out_length = ((in_length / 5) * 4) + (((in_length % 5) > 0) ? ((in_length % 5) - 1) : 0);
 
     if (in_length > ascii85_in_length_max)
     {
@@ -201,42 +621,75 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
     else
     {
         int32_t in_rover = 0;
+        int32_t crc_length = 0; // the CRC lags 4 bytes behind, these might be the trailer
+
+        out_length = 0;
 
-        out_length = 0; // we know we can increment by 4 * ceiling(in_length/5)
+        if (v->alphabet != NULL)
+        {
+            pthread_once(&base85_lut_once, base85_init_luts);
+        }
+
+#ifdef ASCII85_SIMD
+        const bool use_avx2 = ascii85_check_decode_chars && (v->decode_avx2 != NULL) && ascii85_cpu_has_avx2();
+#endif
 
         while (in_rover < in_length)
         {
             uint32_t chunk;
-            int32_t chunk_len = in_length - in_rover;
+            int32_t chunk_len;
 
-#ifdef ENDECODE_NUL_AS_Z
-            if (/*lint -e{506} -e{774}*/ ((uint8_t )'z' == inp[in_rover]))
+#ifdef ASCII85_SIMD
+            if (use_avx2 && ((in_length - in_rover) >= 40) && !base85_special(v, (uint8_t )inp[in_rover]))
+            {
+                // 'z' groups decode to more than the ceiling check above allows for: hand the
+                // kernel no more groups than there is room for
+                int64_t room = (int64_t )((out_max_length - out_length) / 4) * 5;
+                int32_t groups = v->decode_avx2(&inp[in_rover], ((in_length - in_rover) < room) ? (in_length - in_rover)
+                                                                                                : (int32_t )room,
+                                                &outp[out_length]);
+
+                in_rover += groups * 5;
+                out_length += groups * 4;
+                if (in_rover >= in_length)
+                {
+                    break;
+                }
+            }
+#endif
+            chunk_len = in_length - in_rover;
+
+            if (/*lint -e{506} -e{774}*/ v->zero_as_z && ((uint8_t )'z' == (uint8_t )inp[in_rover]))
             {
                 in_rover += 1;
                 chunk = 0u;
                 chunk_len = 5; // to make out_length increment correct
             }
-            else
-#endif
-            if (/*lint -e{506} -e{774}*/ascii85_check_decode_chars
-                    && (                       ascii85_char_ng(inp[in_rover    ])
-                        || ((chunk_len > 1) && ascii85_char_ng(inp[in_rover + 1]))
-                        || ((chunk_len > 2) && ascii85_char_ng(inp[in_rover + 2]))
-                        || ((chunk_len > 3) && ascii85_char_ng(inp[in_rover + 3]))
-                        || ((chunk_len > 4) && ascii85_char_ng(inp[in_rover + 4]))))
+            else if (/*lint -e{506} -e{774}*/ v->spaces_as_y && ((uint8_t )'y' == (uint8_t )inp[in_rover]))
+            {
+                in_rover += 1;
+                chunk = 0x20202020u;
+                chunk_len = 5; // to make out_length increment correct
+            }
+            else if (/*lint -e{506} -e{774}*/ascii85_check_decode_chars
+                    && (                       base85_char_ng(v, inp[in_rover    ])
+                        || ((chunk_len > 1) && base85_char_ng(v, inp[in_rover + 1]))
+                        || ((chunk_len > 2) && base85_char_ng(v, inp[in_rover + 2]))
+                        || ((chunk_len > 3) && base85_char_ng(v, inp[in_rover + 3]))
+                        || ((chunk_len > 4) && base85_char_ng(v, inp[in_rover + 4]))))
             {
                 out_length = (int32_t )ascii85_err_bad_decode_char;
                 break; // leave while loop early to report error
             }
             else if (chunk_len >= 5)
             {
-                chunk  = inp[in_rover++] - base_char;
+                chunk  = base85_digit(v, inp[in_rover++]);
                 chunk *= 85u; // max: 84 * 85 = 7,140
-                chunk += inp[in_rover++] - base_char;
+                chunk += base85_digit(v, inp[in_rover++]);
                 chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
-                chunk += inp[in_rover++] - base_char;
+                chunk += base85_digit(v, inp[in_rover++]);
                 chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
-                chunk += inp[in_rover++] - base_char;
+                chunk += base85_digit(v, inp[in_rover++]);
                 // max: (((((84 * 85 + 84) * 85) + 84) * 85) + 84) * 85 = 4,437,053,040 oops! 0x108780E70
                 if (chunk > (UINT32_MAX / 85u))
                 {
@@ -246,7 +699,7 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
                 }
                 else
                 {
-                    uint8_t addend = inp[in_rover++] - base_char;
+                    uint8_t addend = (uint8_t )base85_digit(v, inp[in_rover++]);
 
                     chunk *= 85u; // multiply will not overflow due to test above
 
@@ -264,13 +717,13 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
             }
             else
             {
-                chunk  = inp[in_rover++] - base_char;
+                chunk  = base85_digit(v, inp[in_rover++]);
                 chunk *= 85u; // max: 84 * 85 = 7,140
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
+                chunk += ((in_rover < in_length) ? base85_digit(v, inp[in_rover++]) : 84u);
                 chunk *= 85u; // max: (84 * 85 + 84) * 85 = 614,040
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
+                chunk += ((in_rover < in_length) ? base85_digit(v, inp[in_rover++]) : 84u);
                 chunk *= 85u; // max: (((84 * 85 + 84) * 85) + 84) * 85 = 52,200,540
-                chunk += ((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
+                chunk += ((in_rover < in_length) ? base85_digit(v, inp[in_rover++]) : 84u);
                 // max: (((((84 * 85 + 84) * 85) + 84) * 85) + 84) * 85 = 4,437,053,040 oops! 0x108780E70
                 if (chunk > (UINT32_MAX / 85u))
                 {
@@ -280,7 +733,7 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
                 }
                 else
                 {
-                    uint8_t addend = (uint8_t )((in_rover < in_length) ? (inp[in_rover++] - base_char) : 84u);
+                    uint8_t addend = (uint8_t )((in_rover < in_length) ? base85_digit(v, inp[in_rover++]) : 84u);
 
                     chunk *= 85u; // multiply will not overflow due to test above
 
@@ -297,57 +750,2332 @@ int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32
                 }
             }
 
-            outp[out_length + 3] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length + 2] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length + 1] = (chunk % 256u);
-            chunk /= 256u;
-            outp[out_length    ] = (uint8_t )chunk;
-            // we don't need (chunk % 256u) on the last line since ((((2^32 - 1) / 256u) / 256u) / 256u) = 255
-
-            if (chunk_len >= 5)
             {
-                out_length += 4;
+                uint8_t group[4];
+                int32_t group_len = (chunk_len >= 5) ? 4 : (chunk_len - 1); // see note above re: Ascii85 length
+
+                if ((out_max_length - out_length) < group_len)
+                {
+                    out_length = (int32_t )ascii85_err_out_buf_too_small; // only possible after 'z'/'y' groups
+                    break; // leave while loop early to report error
+                }
+
+                group[3] = (chunk % 256u);
+                chunk /= 256u;
+                group[2] = (chunk % 256u);
+                chunk /= 256u;
+                group[1] = (chunk % 256u);
+                chunk /= 256u;
+                group[0] = (uint8_t )chunk;
+                // we don't need (chunk % 256u) on the last line since ((((2^32 - 1) / 256u) / 256u) / 256u) = 255
+
+                if (4 == group_len)
+                {
+                    memcpy(&outp[out_length], group, 4);
+                }
+                else
+                {
+                    memcpy(&outp[out_length], group, group_len); // the tail
+                }
+                out_length += group_len;
             }
-            else
+
+            if ((crc != NULL) && ((out_length - 4) > crc_length))
             {
-                out_length += (chunk_len - 1); // see note above re: Ascii85 length
+                *crc = crc32c_update(*crc, &outp[crc_length], (out_length - 4) - crc_length);
+                crc_length = out_length - 4;
             }
         }
+
+        if ((crc != NULL) && (out_length >= 0) && ((out_length - 4) > crc_length))
+        {
+            // the AVX2 kernel consumed the rest of the input
+            *crc = crc32c_update(*crc, &outp[crc_length], (out_length - 4) - crc_length);
+        }
     }
 
     return out_length;
 }
 
-int main(int argc, char **argv) {
-    char out_enc[BUFSIZ];
-    uint8_t out_dec[BUFSIZ];
-    size_t buflen;
-    int32_t siz_enc, siz_dec;
+// The variants: descriptions and their specialized entry points.
 
-#if ENDECODE_NUL_AS_Z
-    printf("Encoding NUL characters won't work from cmdline!\n");
+#ifdef ASCII85_SIMD
+__attribute__((target("avx2")))
+static int32_t decode_ascii85_avx2 (const char *inp, int32_t in_length, uint8_t *outp)
+{
+    return base85_decode_avx2(&base85_ascii85, inp, in_length, outp);
+}
+
+__attribute__((target("avx2")))
+static int32_t decode_z85_avx2 (const char *inp, int32_t in_length, uint8_t *outp)
+{
+    return base85_decode_avx2(&base85_z85, inp, in_length, outp);
+}
+
+__attribute__((target("avx2")))
+static int32_t decode_rfc1924_avx2 (const char *inp, int32_t in_length, uint8_t *outp)
+{
+    return base85_decode_avx2(&base85_rfc1924, inp, in_length, outp);
+}
+
+__attribute__((target("avx2")))
+static int32_t decode_btoa_avx2 (const char *inp, int32_t in_length, uint8_t *outp)
+{
+    return base85_decode_avx2(&base85_btoa, inp, in_length, outp);
+}
+#define BASE85_AVX2(name) decode_##name##_avx2
+#else
+#define BASE85_AVX2(name) NULL
 #endif
-    if (argc != 2) {
-        printf("usage: %s [BINARY-DATA]\n", (argc > 0 ? argv[0] : "null"));
-        exit(1);
-    }
 
-    memset(out_enc, 0, sizeof out_enc);
-    memset(out_dec, 0, sizeof out_dec);
+const struct base85_variant base85_ascii85 =
+{
+    "ascii85", NULL, base_char, NULL,
+#ifdef ENDECODE_NUL_AS_Z
+    true,
+#else
+    false,
+#endif
+    false, encode_ascii85, decode_ascii85, BASE85_AVX2(ascii85)
+};
 
-    buflen = strlen(argv[1]);
-    siz_enc = encode_ascii85((uint8_t *) argv[1], buflen, out_enc, sizeof out_enc - 1);
-    printf("Encoded: \"%.*s\"\n", siz_enc, (char *) out_enc);
-    siz_dec = decode_ascii85(out_enc, siz_enc, out_dec, sizeof out_dec - 1);
+// ZeroMQ RFC 32, no special groups
+const struct base85_variant base85_z85 =
+{
+    "z85", "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#",
+    0, z85_decode_lut, false, false, encode_z85, decode_z85, BASE85_AVX2(z85)
+};
+
+// RFC 1924 alphabet (as used by git binary patches) on 4 byte groups, no special groups
+const struct base85_variant base85_rfc1924 =
+{
+    "rfc1924", "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!#$%&()*+-;<=>?@^_`{|}~",
+    0, rfc1924_decode_lut, false, false, encode_rfc1924, decode_rfc1924, BASE85_AVX2(rfc1924)
+};
+
+// btoa 4.2: Ascii85 alphabet, 'z' for zero groups and 'y' for four spaces
+const struct base85_variant base85_btoa =
+{
+    "btoa", NULL, base_char, NULL, true, true, encode_btoa, decode_btoa, BASE85_AVX2(btoa)
+};
+
+/*!
+ * @brief encode_ascii85: encode binary input into Ascii85
+ * @param[in] inp pointer to a buffer of unsigned bytes 
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data as c-string
+ * @param[in] out_max_length available space at outp in bytes; 5 * ceiling(in_length/4) is always
+ * enough, ascii85_encoded_length(inp, in_length) is the exact size
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ */
+int32_t encode_ascii85 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+{
+    return base85_encode(&base85_ascii85, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief decode_ascii85: decode Ascii85 input to binary output
+ * @param[in] inp pointer to a buffer of Ascii85 encoded c-string
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_decoded_length(inp, in_length, NULL), which is 4 * ceiling(in_length/5) at most unless
+ * there are 'z' groups
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small, 
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow
+ */
+int32_t decode_ascii85 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    return base85_decode(&base85_ascii85, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief encode_z85: like encode_ascii85 with the Z85 alphabet; a partial last group is
+ * encoded like Ascii85 does (plain Z85 requires a multiple of 4 bytes)
+ */
+int32_t encode_z85 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+{
+    return base85_encode(&base85_z85, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief decode_z85: like decode_ascii85 with the Z85 alphabet
+ */
+int32_t decode_z85 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    return base85_decode(&base85_z85, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief encode_rfc1924: like encode_ascii85 with the RFC 1924 alphabet
+ */
+int32_t encode_rfc1924 (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+{
+    return base85_encode(&base85_rfc1924, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief decode_rfc1924: like decode_ascii85 with the RFC 1924 alphabet
+ */
+int32_t decode_rfc1924 (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    return base85_decode(&base85_rfc1924, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief encode_btoa: like encode_ascii85, additionally encodes four spaces as 'y'
+ */
+int32_t encode_btoa (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+{
+    return base85_encode(&base85_btoa, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief decode_btoa: like decode_ascii85, additionally decodes 'y' to four spaces
+ */
+int32_t decode_btoa (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    return base85_decode(&base85_btoa, inp, in_length, outp, out_max_length, NULL);
+}
+
+/*!
+ * @brief encode_ascii85_crc: encode binary input followed by its CRC32C into Ascii85
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 5 * ceiling((in_length + 4)/4)
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par The CRC is computed inside the encoder loop and appended as 4 byte big endian trailer.
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small
+ */
+int32_t encode_ascii85_crc (const uint8_t *inp, int32_t in_length, char *outp, int32_t out_max_length)
+{
+    int32_t full = in_length & ~3, tail = in_length & 3, out_length;
+    uint32_t crc = 0;
+    uint8_t trailer[7];
+
+    if ((in_length > (ascii85_in_length_max - 4)) || (in_length < 0))
+    {
+        return (int32_t )ascii85_err_in_buf_too_large;
+    }
+    if ((((in_length + 4 + 3) / 4) * 5) > out_max_length)
+    {
+        return (int32_t )ascii85_err_out_buf_too_small;
+    }
+
+    crc32c_init();
+    out_length = base85_encode(&base85_ascii85, inp, full, outp, out_max_length, &crc);
+    if (out_length < 0)
+    {
+        return out_length;
+    }
+    crc = crc32c_update(crc, &inp[full], tail);
+
+    memcpy(trailer, &inp[full], tail);
+    trailer[tail    ] = (uint8_t )(crc >> 24);
+    trailer[tail + 1] = (uint8_t )(crc >> 16);
+    trailer[tail + 2] = (uint8_t )(crc >>  8);
+    trailer[tail + 3] = (uint8_t )(crc      );
+    tail = base85_encode(&base85_ascii85, trailer, tail + 4, &outp[out_length], out_max_length - out_length, NULL);
+
+    return (tail < 0) ? tail : (out_length + tail);
+}
+
+/*!
+ * @brief decode_ascii85_crc: decode Ascii85 input and verify its CRC32C trailer
+ * @param[in] inp pointer to a buffer of Ascii85 encoded data (from encode_ascii85_crc)
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data, including the 4 byte trailer
+ * @param[in] out_max_length available space at outp in bytes; must be >=
+ * ascii85_decoded_length(inp, in_length, NULL)
+ * @return number of payload bytes (without trailer) at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_in_buf_too_large, ascii85_err_out_buf_too_small,
+ * ascii85_err_bad_decode_char, ascii85_err_decode_overflow, ascii85_err_crc_mismatch
+ */
+int32_t decode_ascii85_crc (const char *inp, int32_t in_length, uint8_t *outp, int32_t out_max_length)
+{
+    uint32_t crc = 0, trailer;
+    int32_t out_length;
+
+    crc32c_init();
+    out_length = base85_decode(&base85_ascii85, inp, in_length, outp, out_max_length, &crc);
+
+    if (out_length < 0)
+    {
+        return out_length;
+    }
+    if (out_length < 4)
+    {
+        return (int32_t )ascii85_err_crc_mismatch;
+    }
+
+    out_length -= 4;
+    trailer = ((uint32_t )outp[out_length] << 24) | ((uint32_t )outp[out_length + 1] << 16)
+            | ((uint32_t )outp[out_length + 2] << 8) | (uint32_t )outp[out_length + 3];
+
+    return (crc == trailer) ? out_length : (int32_t )ascii85_err_crc_mismatch;
+}
+
+// Exact sizes and in-place decoding. The upper bounds the entry points check against
+// (5 * ceiling(n/4), 4 * ceiling(n/5)) are off by up to a factor of 5 for data with lots of
+// zero groups; these walk the data once to get the exact number of bytes instead, which is
+// cheap compared to the conversion itself and allows sizing allocations exactly.
+
+#define ASCII85_INPLACE_CHUNK 65530 // multiple of 5, <= ascii85_in_length_max
+
+/*!
+ * @brief ascii85_encoded_length: exact size of the Ascii85 encoding of the input
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp
+ * @return number of chars encode_ascii85 (or encode_ascii85_mt) produces for inp
+ */
+int64_t ascii85_encoded_length (const uint8_t *inp, int64_t in_length)
+{
+    int64_t full = in_length / 4, tail = in_length % 4, zeros = 0, i;
+
+    for (i = 0; i < full; i++)
+    {
+        uint32_t group;
+
+        memcpy(&group, &inp[i * 4], sizeof(group));
+        zeros += (0u == group);
+    }
+
+    return (full * 5) - (zeros * 4) + ((tail > 0) ? (tail + 1) : 0);
+}
+
+/*!
+ * @brief ascii85_decoded_length: exact size of the decoded data, counting 'z' groups and the tail
+ * @param[in] inp pointer to a buffer of Ascii85 encoded data
+ * @param[in] in_length the number of bytes at inp
+ * @param[out] inplace_headroom if not NULL: the number of bytes decode_ascii85_inplace needs
+ * behind the input; non-zero only if 'z' groups make a prefix decode longer than it is encoded
+ * @return number of bytes decode_ascii85 (or decode_ascii85_mt) produces for valid input
+ * @par The input is not validated; sizes for bad input are meaningless but bounded by
+ * 4 * in_length, decoding it reports the error.
+ */
+int64_t ascii85_decoded_length (const char *inp, int64_t in_length, int64_t *inplace_headroom)
+{
+    int64_t in_rover = 0, z_count = 0, headroom = 0;
+
+    // 'z' is rare in most data: let memchr run over the stretches of regular groups
+    while (in_rover < in_length)
+    {
+        const char *z = memchr(&inp[in_rover], 'z', (size_t )(in_length - in_rover));
+        int64_t need;
+
+        if (NULL == z)
+        {
+            break;
+        }
+        in_rover = (z - inp) + 1;
+        z_count++;
+        // the decoded prefix ends 4 bytes per group in, the encoded one at in_rover; the
+        // difference peaks right behind a 'z'
+        need = ((z_count + ((in_rover - z_count) / 5)) * 4) - in_rover;
+        headroom = (need > headroom) ? need : headroom;
+    }
+
+    {
+        int64_t nonz = in_length - z_count, tail = nonz % 5;
+
+        int64_t out_length = ((z_count + (nonz / 5)) * 4) + ((tail > 0) ? (tail - 1) : 0);
+
+        if ((out_length - in_length) > headroom)
+        {
+            headroom = out_length - in_length; // a tail behind the last 'z'
+        }
+        if (inplace_headroom != NULL)
+        {
+            *inplace_headroom = headroom;
+        }
+
+        return out_length;
+    }
+}
+
+#ifdef ASCII85_SIMD
+__attribute__((target("avx2,popcnt")))
+static int64_t base85_count_special_avx2 (const uint8_t *inp, int64_t in_length, uint8_t z, uint8_t y)
+{
+    const __m256i vz = _mm256_set1_epi8((char )z);
+    const __m256i vy = _mm256_set1_epi8((char )y);
+    int64_t special = 0, i;
+
+    for (i = 0; (i + 32) <= in_length; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&inp[i]);
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(a, vz), _mm256_cmpeq_epi8(a, vy));
+
+        special += __builtin_popcount((uint32_t )_mm256_movemask_epi8(hit));
+    }
+    for (; i < in_length; i++)
+    {
+        special += (inp[i] == z) || (inp[i] == y);
+    }
+    return special;
+}
+#endif
+
+/* the number of 'z'/'y' chars at inp, 32 per compare and popcount with AVX2 */
+static int64_t base85_count_special (const struct base85_variant *v, const uint8_t *inp, int64_t in_length)
+{
+    // a variant with just one of them looks for it twice
+    uint8_t z = v->zero_as_z ? (uint8_t )'z' : (uint8_t )'y';
+    uint8_t y = v->spaces_as_y ? (uint8_t )'y' : z;
+    int64_t special = 0, i;
+
+    if (!v->zero_as_z && !v->spaces_as_y)
+    {
+        return 0;
+    }
+#ifdef ASCII85_SIMD
+    if (ascii85_cpu_has_avx2())
+    {
+        return base85_count_special_avx2(inp, in_length, z, y);
+    }
+#endif
+    for (i = 0; i < in_length; i++)
+    {
+        special += (inp[i] == z) || (inp[i] == y);
+    }
+    return special;
+}
+
+/*!
+ * @brief base85_complete_groups: length of the complete groups at the start of the input, to
+ * cut encoded data into pieces that can be decoded one after the other
+ * @param[in] v variant
+ * @param[in] inp pointer to a buffer of encoded data, starting at a group boundary
+ * @param[in] in_length the number of bytes at inp
+ * @return number of bytes at inp up to the last group boundary; ascii85_err_bad_decode_char
+ * if a 'z'/'y' is among the chars of the incomplete group (the boundaries don't exist then)
+ */
+int64_t base85_complete_groups (const struct base85_variant *v, const char *inp, int64_t in_length)
+{
+    // all chars except 'z'/'y' belong to 5 char groups
+    int64_t special = base85_count_special(v, (const uint8_t *)inp, in_length);
+    int64_t tail = (in_length - special) % 5, i;
+
+    for (i = in_length - tail; i < in_length; i++)
+    {
+        if (base85_special(v, (uint8_t )inp[i]))
+        {
+            return (int64_t )ascii85_err_bad_decode_char;
+        }
+    }
+
+    return in_length - tail;
+}
+
+/*!
+ * @brief decode_ascii85_inplace: decode Ascii85 data into the buffer it is in
+ * @param[in,out] buf the encoded data on input, the decoded data on output
+ * @param[in] in_length the number of encoded bytes at buf
+ * @param[in] buf_size available space at buf; must be >= in_length plus the inplace_headroom
+ * reported by ascii85_decoded_length, i.e. in_length unless 'z' groups are near the start
+ * @return number of bytes of decoded data at buf if non-negative; error code from
+ * ascii85_errs_e if negative (the contents of buf are undefined then)
+ * @par Decoding runs front to back; the output is never ahead of the input. If headroom is
+ * needed the input is moved up by that much first. There is no size limit on in_length.
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_bad_decode_char,
+ * ascii85_err_decode_overflow
+ */
+int64_t decode_ascii85_inplace (char *buf, int64_t in_length, int64_t buf_size)
+{
+    int64_t headroom, in_rover = 0, out_length = 0;
+    const char *inp;
+
+    (void )ascii85_decoded_length(buf, in_length, &headroom);
+    if ((in_length + headroom) > buf_size)
+    {
+        return (int64_t )ascii85_err_out_buf_too_small;
+    }
+    if (headroom > 0)
+    {
+        memmove(&buf[headroom], buf, (size_t )in_length);
+    }
+    inp = &buf[headroom];
+
+    while (in_rover < in_length)
+    {
+        int32_t chunk = (int32_t )(((in_length - in_rover) < ASCII85_INPLACE_CHUNK) ? (in_length - in_rover)
+                                                                                   : ASCII85_INPLACE_CHUNK);
+        int32_t dec_length;
+
+        if ((in_rover + chunk) < in_length)
+        {
+            int64_t groups = base85_complete_groups(&base85_ascii85, &inp[in_rover], chunk);
+
+            if (groups < 0)
+            {
+                return groups;
+            }
+            chunk = (int32_t )groups;
+        }
+
+        dec_length = decode_ascii85(&inp[in_rover], chunk, (uint8_t *)&buf[out_length], INT32_MAX);
+        if (dec_length < 0)
+        {
+            return (int64_t )dec_length;
+        }
+        in_rover += chunk;
+        out_length += dec_length;
+    }
+
+    return out_length;
+}
+
+// Line-wrapped/framed encoding: the input is encoded into a small stage buffer (that stays in
+// L1) by encode_ascii85 and expanded from there into the output with line breaks inserted, so
+// there is no post-processing copy of the whole output. The wrap state is kept between calls,
+// which allows encoding a stream in pieces.
+
+#define ASCII85_WRAP_STAGE_IN 3276 // multiple of 4, encodes to at most 4095 chars
+
+static int64_t ascii85_wrap_put (struct ascii85_wrap *wrap, const char *src, int32_t length, char *dst)
+{
+    int64_t out_length = 0;
+
+    if (wrap->line_width <= 0)
+    {
+        memcpy(dst, src, length);
+        return length;
+    }
+
+    while (length > 0)
+    {
+        int32_t n = wrap->line_width - wrap->column;
+
+        if (n <= 0)
+        {
+            // break lazily, so the output never ends with an empty line
+            dst[out_length++] = '\n';
+            wrap->column = 0;
+            n = wrap->line_width;
+        }
+        if (n > length)
+        {
+            n = length;
+        }
+        memcpy(&dst[out_length], src, n);
+        out_length += n;
+        wrap->column += n;
+        src += n;
+        length -= n;
+    }
+
+    return out_length;
+}
+
+/*!
+ * @brief ascii85_wrap_max_length: upper bound of the output length of encode_ascii85_wrap
+ * @param[in] wrap line width, framing and current state
+ * @param[in] in_length the number of bytes to encode
+ * @param[in] final true if this is the last piece of the input
+ * @return number of bytes needed at outp
+ */
+int64_t ascii85_wrap_max_length (const struct ascii85_wrap *wrap, int64_t in_length, bool final)
+{
+    int64_t chars = (((in_length + 3) / 4) * 5) + 4; // data, "<~" and "~>"
+
+    if (wrap->line_width > 0)
+    {
+        chars += ((wrap->column + chars) / wrap->line_width) + 2;
+    }
+    return chars + (final ? 1 : 0);
+}
+
+/*!
+ * @brief encode_ascii85_wrap: encode binary input into Ascii85 with line breaks and framing
+ * @param[in,out] wrap line width and framing, keeps the line state between calls
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode; a multiple of 4 unless final
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= ascii85_wrap_max_length()
+ * @param[in] final true if this is the last piece of the input: writes "~>" (if framed), ends
+ * the last line with a line break (if wrapped) and resets the state
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_bad_in_length
+ */
+int64_t encode_ascii85_wrap (struct ascii85_wrap *wrap, const uint8_t *inp, int64_t in_length, char *outp,
+                             int64_t out_max_length, bool final)
+{
+    char stage[((ASCII85_WRAP_STAGE_IN / 4) * 5) + 1];
+    int64_t in_rover = 0, out_length = 0;
+
+    if (!final && ((in_length % 4) != 0))
+    {
+        return (int64_t )ascii85_err_bad_in_length;
+    }
+    if (ascii85_wrap_max_length(wrap, in_length, final) > out_max_length)
+    {
+        return (int64_t )ascii85_err_out_buf_too_small;
+    }
+
+    if (wrap->framed && !wrap->started)
+    {
+        memcpy(outp, "<~", 2);
+        out_length += 2;
+        wrap->column += 2;
+    }
+    wrap->started = true;
+
+    while (in_rover < in_length)
+    {
+        int32_t n = ((in_length - in_rover) > ASCII85_WRAP_STAGE_IN) ? ASCII85_WRAP_STAGE_IN
+                                                                    : (int32_t )(in_length - in_rover);
+        int32_t enc_length = encode_ascii85(&inp[in_rover], n, stage, sizeof(stage));
+
+        if (enc_length < 0)
+        {
+            return enc_length;
+        }
+        out_length += ascii85_wrap_put(wrap, stage, enc_length, &outp[out_length]);
+        in_rover += n;
+    }
+
+    if (final)
+    {
+        if (wrap->framed)
+        {
+            // "~>" must not be split by a line break
+            if ((wrap->line_width > 0) && (wrap->column > 0) && ((wrap->column + 2) > wrap->line_width))
+            {
+                outp[out_length++] = '\n';
+                wrap->column = 0;
+            }
+            memcpy(&outp[out_length], "~>", 2);
+            out_length += 2;
+            wrap->column += 2;
+        }
+        if ((wrap->line_width > 0) && (wrap->column > 0))
+        {
+            outp[out_length++] = '\n';
+        }
+        wrap->column = 0;
+        wrap->started = false;
+    }
+
+    return out_length;
+}
+
+// White space tolerant decoding: non white space chars are compacted into a small stage buffer
+// (that stays in L1) which is decoded by decode_ascii85 as soon as it is full. Only a trailing
+// partial group is carried over to the next stage, so there is no separate pre-pass over the input.
+
+#define ASCII85_WS_STAGE 4096
+
+static uint8_t ascii85_compact_lut[256][8]; // pshufb indices: keep the bytes with a set mask bit
+static pthread_once_t ascii85_compact_once = PTHREAD_ONCE_INIT;
+
+static void ascii85_init_compact_lut (void)
+{
+    unsigned int mask, bit, n;
+
+    for (mask = 0; mask < 256u; mask++)
+    {
+        memset(ascii85_compact_lut[mask], 0x80, sizeof(ascii85_compact_lut[mask]));
+        for (bit = 0, n = 0; bit < 8u; bit++)
+        {
+            if (mask & (1u << bit))
+            {
+                ascii85_compact_lut[mask][n++] = (uint8_t )bit;
+            }
+        }
+    }
+}
+
+static inline bool ascii85_is_white (uint8_t c)
+{
+    // PostScript white space: NUL, TAB, LF, FF, CR and SPACE
+    return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') || (c == '\f') || (c == '\0');
+}
+
+#ifdef ASCII85_SIMD
+/*!
+ * @brief ascii85_compact_avx2: copy 32 byte blocks to stage without white space
+ * @return number of input chars consumed; stops in front of a block containing '~'
+ */
+__attribute__((target("avx2,popcnt")))
+static int64_t ascii85_compact_avx2 (const char *inp, int64_t in_length, char *stage, int32_t *stage_len,
+                                     int32_t *z_count)
+{
+    const __m256i sp = _mm256_set1_epi8(' '), lf = _mm256_set1_epi8('\n'), cr = _mm256_set1_epi8('\r');
+    const __m256i ht = _mm256_set1_epi8('\t'), ff = _mm256_set1_epi8('\f'), nul = _mm256_setzero_si256();
+    const __m256i tilde = _mm256_set1_epi8('~'), z = _mm256_set1_epi8('z');
+    int64_t in_rover = 0;
+    int32_t len = *stage_len;
+
+    // every block may store 8 bytes beyond the kept ones
+    while (((in_length - in_rover) >= 32) && ((len + 32 + 8) <= ASCII85_WS_STAGE))
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&inp[in_rover]);
+        __m256i white = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, lf)),
+                                        _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, ht)));
+        uint32_t keep;
+
+        white = _mm256_or_si256(white, _mm256_or_si256(_mm256_cmpeq_epi8(v, ff), _mm256_cmpeq_epi8(v, nul)));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, tilde)) != 0)
+        {
+            break;
+        }
+        *z_count += __builtin_popcount((uint32_t )_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, z)));
+
+        keep = ~(uint32_t )_mm256_movemask_epi8(white);
+        if (keep == UINT32_MAX)
+        {
+            _mm256_storeu_si256((__m256i *)&stage[len], v);
+            len += 32;
+        }
+        else
+        {
+            int k;
+
+            for (k = 0; k < 4; k++)
+            {
+                uint8_t m = (uint8_t )(keep >> (8 * k));
+                __m128i src = _mm_loadl_epi64((const __m128i *)&inp[in_rover + (8 * k)]);
+
+                _mm_storel_epi64((__m128i *)&stage[len],
+                                 _mm_shuffle_epi8(src, _mm_loadl_epi64((const __m128i *)ascii85_compact_lut[m])));
+                len += __builtin_popcount(m);
+            }
+        }
+        in_rover += 32;
+    }
+
+    *stage_len = len;
+    return in_rover;
+}
+#endif
+
+/*!
+ * @brief ascii85_compact: copy input to stage without white space until the stage is full
+ * @return number of input chars consumed; stops in front of '~'
+ */
+static int64_t ascii85_compact (const char *inp, int64_t in_length, char *stage, int32_t *stage_len,
+                                int32_t *z_count)
+{
+    int64_t in_rover = 0;
+
+#ifdef ASCII85_SIMD
+    if (ascii85_cpu_has_avx2())
+    {
+        in_rover = ascii85_compact_avx2(inp, in_length, stage, stage_len, z_count);
+    }
+#endif
+    while ((in_rover < in_length) && (*stage_len < ASCII85_WS_STAGE))
+    {
+        uint8_t c = (uint8_t )inp[in_rover];
+
+        if ((uint8_t )'~' == c)
+        {
+            break;
+        }
+        if (!ascii85_is_white(c))
+        {
+            *z_count += ((uint8_t )'z' == c);
+            stage[(*stage_len)++] = (char )c;
+        }
+        in_rover++;
+    }
+
+    return in_rover;
+}
+
+/*!
+ * @brief decode_ascii85_ws: decode Ascii85 input to binary output ignoring white space
+ * @param[in] inp pointer to a buffer of Ascii85 encoded data, optionally framed by "<~" and "~>"
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 4 * number of groups
+ * (each 'z' counts as a group)
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Decoding stops at "~>", anything behind it is ignored. A '~' not followed by '>' is
+ * reported as ascii85_err_bad_decode_char.
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_bad_decode_char,
+ * ascii85_err_decode_overflow
+ */
+int64_t decode_ascii85_ws (const char *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length)
+{
+    char stage[ASCII85_WS_STAGE];
+    int32_t stage_len = 0, z_count = 0;
+    int64_t in_rover = 0, out_length = 0;
+    bool done = false;
+
+    pthread_once(&ascii85_compact_once, ascii85_init_compact_lut);
+
+    while ((in_rover < in_length) && ascii85_is_white((uint8_t )inp[in_rover]))
+    {
+        in_rover++;
+    }
+    if (((in_length - in_rover) >= 2) && (inp[in_rover] == '<') && (inp[in_rover + 1] == '~'))
+    {
+        in_rover += 2;
+    }
+
+    while (!done)
+    {
+        int32_t cut, tail, i, z_tail = 0;
+        int64_t groups;
+
+        in_rover += ascii85_compact(&inp[in_rover], in_length - in_rover, stage, &stage_len, &z_count);
+        if (in_rover >= in_length)
+        {
+            done = true;
+        }
+        else if ((uint8_t )'~' == (uint8_t )inp[in_rover])
+        {
+            if (((in_rover + 1) >= in_length) || (inp[in_rover + 1] != '>'))
+            {
+                out_length = (int64_t )ascii85_err_bad_decode_char;
+                break;
+            }
+            done = true;
+        }
+
+        // decode complete groups only, all chars except 'z' belong to 5 char groups
+        tail = (done ? 0 : ((stage_len - z_count) % 5));
+        cut = stage_len - tail;
+        for (i = cut; i < stage_len; i++)
+        {
+            z_tail += ((uint8_t )'z' == (uint8_t )stage[i]);
+        }
+        if (z_tail > 0)
+        {
+            // a 'z' among the chars of an incomplete group: the group boundaries the cut relies
+            // on don't exist, decoding up to the cut would take a partial group for the last one
+            out_length = (int64_t )ascii85_err_bad_decode_char;
+            break;
+        }
+        groups = (z_count - z_tail) + (((cut - (z_count - z_tail)) + 4) / 5);
+        if ((out_length + (groups * 4)) > out_max_length)
+        {
+            out_length = (int64_t )ascii85_err_out_buf_too_small;
+            break;
+        }
+        if (cut > 0)
+        {
+            int32_t dec_length = decode_ascii85(stage, cut, &outp[out_length], INT32_MAX);
+
+            if (dec_length < 0)
+            {
+                out_length = dec_length;
+                break;
+            }
+            out_length += dec_length;
+        }
+
+        memmove(stage, &stage[cut], tail);
+        stage_len = tail;
+        z_count = z_tail;
+    }
+
+    return out_length;
+}
+
+// Serial framing: frames are Ascii85 encoded messages separated by white space. The framer
+// reads from the fd straight into its buffer, scans for delimiters and decodes every complete
+// frame in place, i.e. into the very bytes it was received in, before handing it to a callback.
+// A frame always decodes to fewer bytes than it has, except for 'z' groups (1 char -> 4 bytes);
+// so the decoded frame starts up to 3 bytes per 'z' in front of the encoded one. That space is
+// either already consumed input or the headroom in front of the receive area. The only copy is
+// moving an incomplete frame back to the front once the end of the buffer has been reached.
+
+/*!
+ * @brief ascii85_framer_init: set up a framer
+ * @param[out] framer framer to initialize
+ * @param[in] max_frame_length longest accepted frame (encoded), at most ascii85_in_length_max
+ * @param[in] on_frame called with each decoded frame, or with a NULL pointer and an error code
+ * from ascii85_errs_e as length for bad frames
+ * @param[in] user passed to on_frame
+ * @return 0 on success, -1 if out of memory or max_frame_length is out of range
+ */
+int ascii85_framer_init (struct ascii85_framer *framer, size_t max_frame_length,
+                         void (*on_frame) (void *user, uint8_t *data, int64_t length), void *user)
+{
+    memset(framer, 0, sizeof(*framer));
+    if ((max_frame_length == 0) || (max_frame_length > (size_t )ascii85_in_length_max))
+    {
+        return -1;
+    }
+
+    // worst case: a frame of 'z' only; +4 for the (padded) write of a partial last group
+    framer->headroom = (3 * max_frame_length) + 4;
+    // +1 for the delimiter
+    framer->size = framer->headroom + max_frame_length + 1;
+    framer->buf = malloc(framer->size);
+    if (framer->buf == NULL)
+    {
+        return -1;
+    }
+    framer->start = framer->scan = framer->end = framer->headroom;
+    framer->on_frame = on_frame;
+    framer->user = user;
+
+    return 0;
+}
+
+void ascii85_framer_free (struct ascii85_framer *framer)
+{
+    free(framer->buf);
+    framer->buf = NULL;
+}
+
+static void ascii85_framer_next (struct ascii85_framer *framer, size_t frame_end)
+{
+    framer->start = framer->scan = frame_end + 1; // skip the delimiter
+    framer->frame_groups = framer->frame_nonz = framer->frame_headroom = 0;
+}
+
+static inline void ascii85_framer_group_done (struct ascii85_framer *framer, int64_t in_end)
+{
+    // before the group's 4 bytes are written, the input up to in_end has been read
+    int64_t need = (++framer->frame_groups * 4) - in_end;
+
+    if (need > framer->frame_headroom)
+    {
+        framer->frame_headroom = need;
+    }
+}
+
+static void ascii85_framer_scan (struct ascii85_framer *framer)
+{
+    uint8_t *buf = framer->buf;
+
+    while (framer->scan < framer->end)
+    {
+        uint8_t c = buf[framer->scan];
+        int64_t in_end = (int64_t )(framer->scan - framer->start) + 1;
+
+        if (!ascii85_is_white(c))
+        {
+            if (framer->skipping)
+            {
+                framer->start = framer->scan + 1;
+            }
+            else
+            {
+                if ((uint8_t )'z' == c)
+                {
+                    ascii85_framer_group_done(framer, in_end);
+                }
+                else if ((++framer->frame_nonz % 5) == 0)
+                {
+                    ascii85_framer_group_done(framer, in_end);
+                }
+            }
+            framer->scan++;
+            continue;
+        }
+
+        if (framer->skipping)
+        {
+            framer->skipping = false;
+        }
+        else if (framer->scan > framer->start)
+        {
+            int32_t in_length = (int32_t )(framer->scan - framer->start);
+            int64_t out_length;
+            uint8_t *outp;
+
+            if ((framer->frame_nonz % 5) != 0)
+            {
+                ascii85_framer_group_done(framer, in_length); // partial last group
+            }
+            if ((size_t )framer->frame_headroom > framer->start)
+            {
+                framer->on_frame(framer->user, NULL, (int64_t )ascii85_err_out_buf_too_small);
+            }
+            else
+            {
+                outp = &buf[framer->start - framer->frame_headroom];
+                out_length = (framer->check_crc ? decode_ascii85_crc : decode_ascii85)
+                             ((const char *)&buf[framer->start], in_length, outp,
+                              in_length + (int32_t )framer->frame_headroom);
+                framer->on_frame(framer->user, (out_length < 0 ? NULL : outp), out_length);
+            }
+        }
+        ascii85_framer_next(framer, framer->scan);
+    }
+}
+
+/*!
+ * @brief ascii85_framer_read: read once from fd and dispatch all frames completed by the data
+ * @param[in,out] framer framer
+ * @param[in] fd file descriptor to read from (tty, pipe, socket, ..)
+ * @return result of read(2): number of bytes read, 0 on end of file, -1 on error (see errno)
+ * @par An incomplete frame at the end of file is not dispatched.
+ */
+ssize_t ascii85_framer_read (struct ascii85_framer *framer, int fd)
+{
+    ssize_t got;
+
+    if (framer->start == framer->end)
+    {
+        framer->start = framer->scan = framer->end = framer->headroom;
+    }
+    else if (framer->end == framer->size)
+    {
+        if (framer->start > framer->headroom)
+        {
+            size_t pending = framer->end - framer->start;
+
+            memmove(&framer->buf[framer->headroom], &framer->buf[framer->start], pending);
+            framer->scan -= framer->start - framer->headroom;
+            framer->start = framer->headroom;
+            framer->end = framer->headroom + pending;
+        }
+        else
+        {
+            // frame does not fit: report it and drop everything up to the next delimiter
+            framer->on_frame(framer->user, NULL, (int64_t )ascii85_err_in_buf_too_large);
+            framer->skipping = true;
+            ascii85_framer_next(framer, framer->headroom - 1);
+            framer->end = framer->headroom;
+        }
+    }
+
+    got = read(fd, &framer->buf[framer->end], framer->size - framer->end);
+    if (got > 0)
+    {
+        framer->end += got;
+        ascii85_framer_scan(framer);
+    }
+
+    return got;
+}
+
+// Parallel en/decoding: the input is cut into chunks small enough for the functions above
+// (ascii85_in_length_max) that always start at a group boundary. A first parallel pass counts
+// what makes the output length of a chunk data dependent (all-zero groups resp. 'z' chars),
+// a prefix sum over those counts yields the output offset of every chunk and a second
+// parallel pass en/decodes all chunks directly into their final place in the output buffer.
+
+static const int64_t ascii85_mt_enc_chunk = 65536; // multiple of 4
+static const int64_t ascii85_mt_dec_chunk = 65530; // multiple of 5, +4 for boundary alignment
+
+struct ascii85_mt_chunk
+{
+    int64_t in_offset;
+    int64_t in_length;
+    int64_t out_offset;
+    int64_t result; // pass 1: zero groups or 'z' count, pass 2: en/decoded length or error
+};
+
+struct ascii85_mt_job
+{
+    const struct base85_variant *variant;
+    const uint8_t *inp;
+    uint8_t *outp;
+    struct ascii85_mt_chunk *chunks;
+    size_t first_chunk;
+    size_t last_chunk;
+    void (*process)(const struct ascii85_mt_job *job, struct ascii85_mt_chunk *chunk);
+};
+
+static void ascii85_mt_count_special_groups (const struct ascii85_mt_job *job, struct ascii85_mt_chunk *chunk)
+{
+    const struct base85_variant *v = job->variant;
+    const uint8_t *inp = job->inp + chunk->in_offset;
+    int64_t i, special_groups = 0;
+
+    if (!v->zero_as_z && !v->spaces_as_y)
+    {
+        chunk->result = 0;
+        return;
+    }
+    for (i = 0; i + 4 <= chunk->in_length; i += 4)
+    {
+        uint32_t group = ((uint32_t )inp[i] << 24u) | ((uint32_t )inp[i + 1] << 16u)
+                       | ((uint32_t )inp[i + 2] << 8u) | (uint32_t )inp[i + 3];
+
+        special_groups += (v->zero_as_z && (0u == group)) || (v->spaces_as_y && (0x20202020u == group));
+    }
+    chunk->result = special_groups;
+}
+
+static void ascii85_mt_count_special (const struct ascii85_mt_job *job, struct ascii85_mt_chunk *chunk)
+{
+    chunk->result = base85_count_special(job->variant, job->inp + chunk->in_offset, chunk->in_length);
+}
+
+static void ascii85_mt_encode_chunk (const struct ascii85_mt_job *job, struct ascii85_mt_chunk *chunk)
+{
+    chunk->result = job->variant->encode(job->inp + chunk->in_offset, (int32_t )chunk->in_length,
+                                         (char *)job->outp + chunk->out_offset, INT32_MAX);
+}
+
+static void ascii85_mt_decode_chunk (const struct ascii85_mt_job *job, struct ascii85_mt_chunk *chunk)
+{
+    // the caller has checked that the whole output fits, every chunk stays within its part
+    chunk->result = job->variant->decode((const char *)job->inp + chunk->in_offset, (int32_t )chunk->in_length,
+                                         job->outp + chunk->out_offset, INT32_MAX);
+}
+
+static void *ascii85_mt_worker (void *arg)
+{
+    const struct ascii85_mt_job *job = (const struct ascii85_mt_job *)arg;
+    size_t i;
+
+    for (i = job->first_chunk; i < job->last_chunk; i++)
+    {
+        job->process(job, &job->chunks[i]);
+    }
+    return NULL;
+}
+
+static void ascii85_mt_run (const struct ascii85_mt_job *tmpl, size_t chunk_count, unsigned int threads)
+{
+    struct ascii85_mt_job jobs[threads];
+    pthread_t tids[threads];
+    bool started[threads];
+    unsigned int t;
+
+    for (t = 0; t < threads; t++)
+    {
+        jobs[t] = *tmpl;
+        jobs[t].first_chunk = (chunk_count * t) / threads;
+        jobs[t].last_chunk = (chunk_count * (t + 1)) / threads;
+        // the calling thread takes the first range and whatever could not be started
+        started[t] = (t > 0) && (pthread_create(&tids[t], NULL, ascii85_mt_worker, &jobs[t]) == 0);
+    }
+    for (t = 0; t < threads; t++)
+    {
+        if (!started[t])
+        {
+            (void)ascii85_mt_worker(&jobs[t]);
+        }
+    }
+    for (t = 1; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(tids[t], NULL);
+        }
+    }
+}
+
+static unsigned int ascii85_mt_threads (unsigned int threads, size_t chunk_count)
+{
+    if (chunk_count <= 1u)
+    {
+        return 1u; // no need to ask for the cpus
+    }
+    if (threads == 0u)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (unsigned int)cpus : 1u;
+    }
+    if (threads > chunk_count)
+    {
+        threads = (unsigned int)chunk_count;
+    }
+    return threads;
+}
+
+// With one thread the chunks are en/decoded one after the other, each one right behind the
+// output of the previous one: the counting pass is not needed for that.
+
+static int64_t ascii85_serial_encode (const struct base85_variant *v, const uint8_t *inp, int64_t in_length,
+                                      char *outp, int64_t out_max_length)
+{
+    int64_t in_rover = 0, out_length = 0;
+
+    while (in_rover < in_length)
+    {
+        int64_t n = ((in_length - in_rover) < ascii85_mt_enc_chunk) ? (in_length - in_rover) : ascii85_mt_enc_chunk;
+        int64_t room = out_max_length - out_length;
+        int32_t done = v->encode(&inp[in_rover], (int32_t )n, &outp[out_length],
+                                 (room < INT32_MAX) ? (int32_t )room : INT32_MAX);
+
+        if (done < 0)
+        {
+            return done;
+        }
+        in_rover += n;
+        out_length += done;
+    }
+    return out_length;
+}
+
+static int64_t ascii85_serial_decode (const struct base85_variant *v, const char *inp, int64_t in_length,
+                                      uint8_t *outp, int64_t out_max_length)
+{
+    int64_t in_rover = 0, out_length = 0;
+
+    while (in_rover < in_length)
+    {
+        int64_t n = ((in_length - in_rover) < ascii85_mt_dec_chunk) ? (in_length - in_rover) : ascii85_mt_dec_chunk;
+        int64_t room = out_max_length - out_length;
+        int32_t done;
+
+        if ((in_rover + n) < in_length)
+        {
+            // all but the last piece end at a group boundary
+            n = base85_complete_groups(v, &inp[in_rover], n);
+            if (n < 0)
+            {
+                return n;
+            }
+        }
+        done = v->decode(&inp[in_rover], (int32_t )n, &outp[out_length], (room < INT32_MAX) ? (int32_t )room : INT32_MAX);
+        if (done < 0)
+        {
+            return done;
+        }
+        in_rover += n;
+        out_length += done;
+    }
+    return out_length;
+}
+
+/*!
+ * @brief base85_encode_mt: encode binary input of any size into base85 using multiple threads
+ * @param[in] v variant to encode
+ * @param[in] inp pointer to a buffer of unsigned bytes
+ * @param[in] in_length the number of bytes at inp to encode
+ * @param[in] outp pointer to a buffer for the encoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= the exact encoded length
+ * @param[in] threads number of threads to use, 0 for one per online cpu
+ * @return number of bytes in the encoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_out_of_memory
+ */
+int64_t base85_encode_mt (const struct base85_variant *v, const uint8_t *inp, int64_t in_length, char *outp,
+                          int64_t out_max_length, unsigned int threads)
+{
+    size_t chunk_count = (size_t )((in_length + ascii85_mt_enc_chunk - 1) / ascii85_mt_enc_chunk);
+    struct ascii85_mt_chunk *chunks;
+    struct ascii85_mt_job job = { v, inp, (uint8_t *)outp, NULL, 0, 0, ascii85_mt_count_special_groups };
+    int64_t out_length = 0;
+    size_t i;
+
+    threads = ascii85_mt_threads(threads, chunk_count);
+    if (threads == 1u)
+    {
+        return ascii85_serial_encode(v, inp, in_length, outp, out_max_length);
+    }
+    chunks = calloc(chunk_count + 1, sizeof(*chunks));
+    if (chunks == NULL)
+    {
+        return (int64_t )ascii85_err_out_of_memory;
+    }
+    job.chunks = chunks;
+
+    for (i = 0; i < chunk_count; i++)
+    {
+        chunks[i].in_offset = (int64_t )i * ascii85_mt_enc_chunk;
+        chunks[i].in_length = in_length - chunks[i].in_offset;
+        if (chunks[i].in_length > ascii85_mt_enc_chunk)
+        {
+            chunks[i].in_length = ascii85_mt_enc_chunk;
+        }
+    }
+    ascii85_mt_run(&job, chunk_count, threads);
+
+    for (i = 0; i < chunk_count; i++)
+    {
+        int64_t tail = chunks[i].in_length % 4;
+
+        chunks[i].out_offset = out_length;
+        out_length += ((chunks[i].in_length / 4) * 5) - (chunks[i].result * 4) + ((tail > 0) ? (tail + 1) : 0);
+    }
+
+    if (out_length > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        job.process = ascii85_mt_encode_chunk;
+        ascii85_mt_run(&job, chunk_count, threads);
+        for (i = 0; i < chunk_count; i++)
+        {
+            if (chunks[i].result < 0)
+            {
+                out_length = chunks[i].result;
+                break;
+            }
+        }
+    }
+
+    free(chunks);
+    return out_length;
+}
+
+/*!
+ * @brief base85_decode_mt: decode base85 input of any size to binary output using multiple threads
+ * @param[in] v variant to decode
+ * @param[in] inp pointer to a buffer of base85 encoded data
+ * @param[in] in_length the number of bytes at inp to decode
+ * @param[in] outp pointer to a buffer for the decoded data
+ * @param[in] out_max_length available space at outp in bytes; must be >= 4 * number of groups
+ * (each 'z'/'y' counts as a group)
+ * @param[in] threads number of threads to use, 0 for one per online cpu
+ * @return number of bytes in the decoded value at outp if non-negative; error code from
+ * ascii85_errs_e if negative
+ * @par Possible errors include: ascii85_err_out_buf_too_small, ascii85_err_bad_decode_char,
+ * ascii85_err_decode_overflow, ascii85_err_out_of_memory
+ */
+int64_t base85_decode_mt (const struct base85_variant *v, const char *inp, int64_t in_length, uint8_t *outp,
+                          int64_t out_max_length, unsigned int threads)
+{
+    size_t chunk_count = (size_t )((in_length + ascii85_mt_dec_chunk - 1) / ascii85_mt_dec_chunk);
+    struct ascii85_mt_chunk *chunks;
+    struct ascii85_mt_job job = { v, (const uint8_t *)inp, outp, NULL, 0, 0, ascii85_mt_count_special };
+    int64_t z_before = 0, out_length = 0, out_needed;
+    size_t i, decode_count = chunk_count;
+
+    threads = ascii85_mt_threads(threads, chunk_count);
+    if (threads == 1u)
+    {
+        return ascii85_serial_decode(v, inp, in_length, outp, out_max_length);
+    }
+    chunks = calloc(chunk_count + 1, sizeof(*chunks));
+    if (chunks == NULL)
+    {
+        return (int64_t )ascii85_err_out_of_memory;
+    }
+    job.chunks = chunks;
+
+    for (i = 0; i < chunk_count; i++)
+    {
+        chunks[i].in_offset = (int64_t )i * ascii85_mt_dec_chunk;
+        chunks[i].in_length = in_length - chunks[i].in_offset;
+        if (chunks[i].in_length > ascii85_mt_dec_chunk)
+        {
+            chunks[i].in_length = ascii85_mt_dec_chunk;
+        }
+    }
+    ascii85_mt_run(&job, chunk_count, threads);
+
+    // Move every chunk start forward to the next group boundary: all chars that are not 'z'/'y'
+    // belong to 5 char groups, so (offset - special count) mod 5 tells how far into a group a
+    // chunk starts.
+    for (i = 0; i < chunk_count; i++)
+    {
+        int64_t start = chunks[i].in_offset;
+        int64_t group_pos = (start - z_before) % 5;
+        int64_t z_start = z_before;
+
+        z_before += chunks[i].result;
+        while ((group_pos != 0) && (start < in_length))
+        {
+            if (base85_special(v, (uint8_t )inp[start++]))
+            {
+                // 'z'/'y' inside a group: the previous chunk ends with it and reports the bad char
+                decode_count = (i < decode_count) ? i : decode_count;
+                break;
+            }
+            group_pos = (group_pos + 1) % 5;
+        }
+        chunks[i].in_offset = start;
+        chunks[i].out_offset = (z_start + ((start - z_start) / 5)) * 4;
+    }
+    chunks[chunk_count].in_offset = in_length;
+    for (i = 0; i < chunk_count; i++)
+    {
+        chunks[i].in_length = chunks[i + 1].in_offset - chunks[i].in_offset;
+    }
+    out_needed = ((z_before + ((in_length - z_before) / 5)) * 4)
+               + ((((in_length - z_before) % 5) > 0) ? (((in_length - z_before) % 5) - 1) : 0);
+
+    if (out_needed > out_max_length)
+    {
+        out_length = (int64_t )ascii85_err_out_buf_too_small;
+    }
+    else
+    {
+        job.process = ascii85_mt_decode_chunk;
+        ascii85_mt_run(&job, decode_count, ascii85_mt_threads(threads, decode_count));
+        for (i = 0; i < decode_count; i++)
+        {
+            if (chunks[i].result < 0)
+            {
+                out_length = chunks[i].result;
+                break;
+            }
+            out_length = chunks[i].out_offset + chunks[i].result;
+        }
+        if ((out_length >= 0) && (decode_count < chunk_count))
+        {
+            out_length = (int64_t )ascii85_err_bad_decode_char;
+        }
+    }
+
+    free(chunks);
+    return out_length;
+}
+
+int64_t encode_ascii85_mt (const uint8_t *inp, int64_t in_length, char *outp, int64_t out_max_length,
+                           unsigned int threads)
+{
+    return base85_encode_mt(&base85_ascii85, inp, in_length, outp, out_max_length, threads);
+}
+
+int64_t decode_ascii85_mt (const char *inp, int64_t in_length, uint8_t *outp, int64_t out_max_length,
+                           unsigned int threads)
+{
+    return base85_decode_mt(&base85_ascii85, inp, in_length, outp, out_max_length, threads);
+}
+
+static void print_usage_and_exit (char *arg0)
+{
+    fprintf(stderr, "usage: %s [options] [BINARY-DATA]\n\n%s", (arg0 != NULL ? arg0 : "null"),
+        "where [options] can be:\n"
+        "\t-e\tencode BINARY-DATA (or stdin) to stdout\n"
+        "\t-d\tdecode BINARY-DATA (or stdin) to stdout\n"
+        "\t-w\tdecode ignoring white space and <~ ~> delimiters (implies -d)\n"
+        "\t-t\tnumber of threads for -e/-d (0: one per cpu, default: 1)\n"
+        "\t-l\tline width of the encoded output, 0 (none) or at least 2 (streams stdin, no threads)\n"
+        "\t-a\tenclose the encoded output in <~ ~> (streams stdin, no threads)\n"
+        "\t-V\tvariant for -e/-d: ascii85 (default), z85, rfc1924 or btoa\n"
+        "\t-s\tdecode white space separated frames from the tty BINARY-DATA (or stdin)\n"
+        "\t-c\tappend (-e) or verify and strip (-d, -s) a CRC32C trailer, up to 64k input\n"
+        "\t-f\tencode/decode FILE instead of BINARY-DATA or stdin (memory-mapped)\n"
+        "\t-b\tbenchmark the scalar, SIMD and threaded paths, JSON results to stdout\n"
+        "\t-C\tcompare the benchmark with the results in BASELINE, fail on regressions\n"
+        "\t-T\tregression threshold for -C in percent (default: 10)\n"
+        "\t-h\tthis help\n\n"
+        "without -e/-d BINARY-DATA is encoded, decoded and compared\n"
+        );
+    exit(EXIT_FAILURE);
+}
+
+static uint8_t *read_all (int fd, size_t *length)
+{
+    size_t size = BUFSIZ;
+    uint8_t *buf = malloc(size);
+    ssize_t got;
+
+    *length = 0;
+    while (buf != NULL && (got = read(fd, buf + *length, size - *length)) != 0)
+    {
+        if (got < 0)
+        {
+            free(buf);
+            return NULL;
+        }
+        *length += got;
+        if (*length == size)
+        {
+            uint8_t *tmp = realloc(buf, size * 2);
+            if (tmp == NULL)
+            {
+                free(buf);
+                return NULL;
+            }
+            buf = tmp;
+            size *= 2;
+        }
+    }
+    return buf;
+}
+
+struct options
+{
+    bool encode;
+    bool tolerant;
+    bool crc;
+    const struct base85_variant *variant;
+    unsigned int threads;
+    struct ascii85_wrap wrap;
+};
+
+static bool is_wrapped (const struct options *opts)
+{
+    return (opts->wrap.line_width > 0) || opts->wrap.framed;
+}
+
+static int endecode (char *arg0, struct options *opts, const uint8_t *inp, size_t in_length)
+{
+    int64_t out_max_length, out_length;
+    uint8_t *outp;
+
+    if (opts->crc && opts->encode && in_length > (size_t )ascii85_in_length_max - 4)
+    {
+        fprintf(stderr, "%s: -c is limited to %d bytes of input\n", arg0, (int)ascii85_in_length_max - 4);
+        return 1;
+    }
+
+    if (opts->encode && opts->variant == &base85_ascii85 && !opts->crc && !is_wrapped(opts))
+    {
+        out_max_length = ascii85_encoded_length(inp, in_length);
+    }
+    else if (opts->encode)
+    {
+        out_max_length = ascii85_wrap_max_length(&opts->wrap, in_length + (opts->crc ? 4 : 0), true);
+    }
+    else if (opts->tolerant)
+    {
+        out_max_length = in_length * 4;
+    }
+    else
+    {
+        // a trailing newline from echo/files is not part of the data
+        while (in_length > 0 && (inp[in_length - 1] == '\n' || inp[in_length - 1] == '\r'))
+        {
+            in_length--;
+        }
+        if (opts->variant == &base85_ascii85)
+        {
+            out_max_length = ascii85_decoded_length((const char *)inp, in_length, NULL);
+        }
+        else
+        {
+            out_max_length = in_length * 4;
+        }
+    }
+
+    outp = malloc(out_max_length + 1);
+    if (outp == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    if (opts->crc && opts->encode)
+    {
+        out_length = encode_ascii85_crc(inp, in_length, (char *)outp, out_max_length);
+    }
+    else if (opts->crc)
+    {
+        out_length = decode_ascii85_crc((const char *)inp, in_length, outp, out_max_length);
+    }
+    else if (opts->encode && is_wrapped(opts))
+    {
+        out_length = encode_ascii85_wrap(&opts->wrap, inp, in_length, (char *)outp, out_max_length, true);
+    }
+    else if (opts->encode)
+    {
+        out_length = base85_encode_mt(opts->variant, inp, in_length, (char *)outp, out_max_length, opts->threads);
+    }
+    else if (opts->tolerant)
+    {
+        out_length = decode_ascii85_ws((const char *)inp, in_length, outp, out_max_length);
+    }
+    else
+    {
+        out_length = base85_decode_mt(opts->variant, (const char *)inp, in_length, outp, out_max_length,
+                                      opts->threads);
+    }
+
+    if (out_length < 0)
+    {
+        fprintf(stderr, "%s: %s failed with error %lld\n", arg0, (opts->encode ? "encoding" : "decoding"),
+                (long long int)out_length);
+        free(outp);
+        return 1;
+    }
+
+    if (opts->encode && opts->wrap.line_width <= 0)
+    {
+        outp[out_length++] = '\n';
+    }
+    fwrite(outp, 1, out_length, stdout);
+    free(outp);
+    return 0;
+}
+
+/* decode the buffer read_all returned in place, there is no second buffer for the output */
+static int decode_inplace (char *arg0, uint8_t **inp, size_t in_length)
+{
+    int64_t headroom, out_length;
+
+    while (in_length > 0 && ((*inp)[in_length - 1] == '\n' || (*inp)[in_length - 1] == '\r'))
+    {
+        in_length--;
+    }
+    (void )ascii85_decoded_length((const char *)*inp, in_length, &headroom);
+    if (headroom > 0)
+    {
+        uint8_t *grown = realloc(*inp, in_length + headroom);
+
+        if (grown == NULL)
+        {
+            perror("realloc");
+            return 1;
+        }
+        *inp = grown;
+    }
+
+    out_length = decode_ascii85_inplace((char *)*inp, in_length, in_length + headroom);
+    if (out_length < 0)
+    {
+        fprintf(stderr, "%s: decoding failed with error %lld\n", arg0, (long long int)out_length);
+        return 1;
+    }
+    fwrite(*inp, 1, out_length, stdout);
+    return 0;
+}
+
+/* encode stdin to stdout in pieces, memory usage does not depend on the input size */
+static int encode_stream (char *arg0, struct options *opts, int fd)
+{
+    uint8_t inp[65536];
+    char *outp;
+    size_t in_length = 0, out_max_length;
+    ssize_t got;
+    bool final = false;
+
+    // at most one line break per two chars
+    out_max_length = (ascii85_wrap_max_length(&opts->wrap, sizeof(inp), true) * 2) + 1;
+    outp = malloc(out_max_length);
+    if (outp == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    while (!final)
+    {
+        int64_t out_length;
+        size_t n;
+
+        got = read(fd, inp + in_length, sizeof(inp) - in_length);
+        if (got < 0)
+        {
+            perror("read");
+            free(outp);
+            return 1;
+        }
+        in_length += got;
+        final = (got == 0);
+
+        n = (final ? in_length : (in_length & ~(size_t )3)); // full groups unless final
+        if (n == 0 && !final)
+        {
+            continue;
+        }
+        out_length = encode_ascii85_wrap(&opts->wrap, inp, n, outp, out_max_length, final);
+        if (out_length < 0)
+        {
+            fprintf(stderr, "%s: encoding failed with error %lld\n", arg0, (long long int)out_length);
+            free(outp);
+            return 1;
+        }
+        if (final && opts->wrap.line_width <= 0)
+        {
+            outp[out_length++] = '\n';
+        }
+        fwrite(outp, 1, out_length, stdout);
+        memmove(inp, inp + n, in_length - n);
+        in_length -= n;
+    }
+
+    free(outp);
+    return 0;
+}
+
+static void print_frame (void *user, uint8_t *data, int64_t length)
+{
+    if (length < 0)
+    {
+        fprintf(stderr, "%s: dropped frame, error %lld\n", (char *)user, (long long int)length);
+        return;
+    }
+    fwrite(data, 1, length, stdout);
+    fflush(stdout);
+}
+
+/* the settings of the tty decode_frames put in raw mode, until they are restored */
+static struct termios frames_tio;
+static int frames_tty = -1;
+
+static void frames_tty_restore (void)
+{
+    if (frames_tty >= 0)
+    {
+        tcsetattr(frames_tty, TCSANOW, &frames_tio);
+        frames_tty = -1;
+    }
+}
+
+static void frames_signal (int sig)
+{
+    frames_tty_restore();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* decode white space separated frames from a tty (set to raw mode) or stdin */
+static int decode_frames (char *arg0, const char *path, bool check_crc)
+{
+    struct ascii85_framer framer;
+    struct termios tio;
+    int fd = STDIN_FILENO;
+    ssize_t got;
+
+    if (path != NULL)
+    {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+        if (fd < 0)
+        {
+            perror("open");
+            return 1;
+        }
+    }
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0)
+    {
+        frames_tio = tio;
+        frames_tty = fd;
+        signal(SIGINT, frames_signal);
+        signal(SIGTERM, frames_signal);
+        cfmakeraw(&tio);
+        tio.c_lflag |= ISIG; // ^C still ends it, it is no ascii85 char anyway
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    if (ascii85_framer_init(&framer, ascii85_in_length_max, print_frame, arg0) != 0)
+    {
+        perror("ascii85_framer_init");
+        got = -1;
+    }
+    else
+    {
+        framer.check_crc = check_crc;
+        do {
+            got = ascii85_framer_read(&framer, fd);
+        } while (got > 0 || (got < 0 && errno == EINTR));
+        if (got < 0)
+        {
+            perror("read");
+        }
+        ascii85_framer_free(&framer);
+    }
+
+    frames_tty_restore();
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    if (path != NULL)
+    {
+        close(fd);
+    }
+    return (got < 0 ? 1 : 0);
+}
+
+/* output through a few large page aligned buffers, handed to the kernel by one writev */
+#define OUT_VEC_BUF_SIZE  (1 << 20)
+#define OUT_VEC_BUF_COUNT 8
+
+struct out_vec
+{
+    int fd;
+    uint8_t *mem;
+    struct iovec iov[OUT_VEC_BUF_COUNT];
+    int used;
+};
+
+static int out_vec_flush (struct out_vec *out)
+{
+    struct iovec *iov = out->iov;
+    int count = out->used;
+
+    while (count > 0)
+    {
+        ssize_t n = writev(out->fd, iov, count);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        while (count > 0 && (size_t )n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    out->used = 0;
+    return 0;
+}
+
+/* the next buffer to fill, OUT_VEC_BUF_SIZE bytes */
+static uint8_t *out_vec_next (struct out_vec *out)
+{
+    return out->mem + (size_t )out->used * OUT_VEC_BUF_SIZE;
+}
+
+static int out_vec_commit (struct out_vec *out, size_t length)
+{
+    out->iov[out->used].iov_base = out_vec_next(out);
+    out->iov[out->used].iov_len = length;
+    out->used++;
+    return (out->used == OUT_VEC_BUF_COUNT) ? out_vec_flush(out) : 0;
+}
+
+/* encode or decode the mapped file piece by piece into the output buffers; single threaded
+   the pieces are what the plain functions take, with threads they fill one buffer each */
+static int endecode_mapped (char *arg0, struct options *opts, const uint8_t *inp, size_t in_length)
+{
+    struct out_vec out = { STDOUT_FILENO, NULL, { { NULL, 0 } }, 0 };
+    const size_t room = OUT_VEC_BUF_SIZE - 1; // one byte is left for the final newline
+    size_t in_rover = 0, fill = 0, piece;
+    int ret = 0;
+
+    if (posix_memalign((void **)&out.mem, 4096, (size_t )OUT_VEC_BUF_SIZE * OUT_VEC_BUF_COUNT) != 0)
+    {
+        perror("posix_memalign");
+        return 1;
+    }
+
+    if (opts->encode)
+    {
+        piece = (opts->threads == 1) ? (size_t )ascii85_in_length_max : (room / 5) * 4;
+        while (is_wrapped(opts) && ascii85_wrap_max_length(&opts->wrap, piece, true) > (int64_t )room)
+        {
+            piece = (piece / 2) & ~(size_t )3;
+        }
+    }
+    else
+    {
+        // a piece decodes to at most 4 bytes per char ('z')
+        piece = (opts->threads == 1) ? (size_t )ascii85_in_length_max : room / 4;
+        while (in_length > 0 && (inp[in_length - 1] == '\n' || inp[in_length - 1] == '\r'))
+        {
+            in_length--;
+        }
+    }
+
+    do {
+        size_t n = (in_length - in_rover < piece) ? in_length - in_rover : piece;
+        bool final = (in_rover + n == in_length);
+        int64_t out_length;
+
+        if (!opts->encode && !final)
+        {
+            int64_t groups = base85_complete_groups(opts->variant, (const char *)inp + in_rover, n);
+
+            if (groups < 0)
+            {
+                fprintf(stderr, "%s: decoding failed with error %lld\n", arg0, (long long int)groups);
+                ret = 1;
+                break;
+            }
+            n = (size_t )groups;
+        }
+        if (is_wrapped(opts) && ascii85_wrap_max_length(&opts->wrap, n, final) > (int64_t )(room - fill))
+        {
+            out_length = (int64_t )ascii85_err_out_buf_too_small; // the wrap state must not move
+        }
+        else if (is_wrapped(opts))
+        {
+            out_length = encode_ascii85_wrap(&opts->wrap, inp + in_rover, n, (char *)out_vec_next(&out) + fill,
+                                             room - fill, final);
+        }
+        else if (opts->encode)
+        {
+            out_length = base85_encode_mt(opts->variant, inp + in_rover, n, (char *)out_vec_next(&out) + fill,
+                                          room - fill, opts->threads);
+        }
+        else
+        {
+            out_length = base85_decode_mt(opts->variant, (const char *)inp + in_rover, n, out_vec_next(&out) + fill,
+                                          room - fill, opts->threads);
+        }
+
+        if (out_length == (int64_t )ascii85_err_out_buf_too_small && fill > 0)
+        {
+            // the buffer is full: pass it on, the piece is redone in the next one
+            if (out_vec_commit(&out, fill) != 0)
+            {
+                perror("writev");
+                ret = 1;
+                break;
+            }
+            fill = 0;
+            continue;
+        }
+        if (out_length < 0)
+        {
+            fprintf(stderr, "%s: %s failed with error %lld\n", arg0, (opts->encode ? "encoding" : "decoding"),
+                    (long long int)out_length);
+            ret = 1;
+            break;
+        }
+        fill += out_length;
+        in_rover += n;
+    } while (in_rover < in_length);
+
+    if (ret == 0)
+    {
+        if (opts->encode && opts->wrap.line_width <= 0)
+        {
+            out_vec_next(&out)[fill++] = '\n';
+        }
+        if ((fill > 0 && out_vec_commit(&out, fill) != 0) || out_vec_flush(&out) != 0)
+        {
+            perror("writev");
+            ret = 1;
+        }
+    }
+    free(out.mem);
+    return ret;
+}
+
+/* Benchmark: MB/s (of binary data) of encoding and decoding, for the scalar code, the AVX2
+   decoder and the threaded functions, over a few sizes and data distributions. The scalar and
+   SIMD paths use the plain functions on pieces they accept, the threaded ones take it all. */
+
+#define BENCH_PIECE 52428 // multiple of 4, encodes to at most 65535 chars
+
+struct bench_result
+{
+    char path[16];
+    char op[16];
+    char dist[16];
+    size_t size;
+    double mbps;
+};
+
+struct bench_data
+{
+    uint8_t *raw;
+    char *enc;
+    uint8_t *dec;
+    size_t size;
+    int64_t enc_length;
+    int32_t *piece_length; // encoded length of each piece
+};
+
+static double bench_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench_fill (uint8_t *raw, size_t size, const char *dist)
+{
+    static const char words[] = "the quick brown fox jumps over the lazy dog, 1234567890.\n";
+    uint64_t x = 0x9E3779B97F4A7C15u;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        if (strcmp(dist, "random") == 0)
+            raw[i] = (uint8_t )x;
+        else if (strcmp(dist, "zero") == 0)
+            raw[i] = 0;
+        else
+            raw[i] = (uint8_t )words[x % (sizeof(words) - 1)];
+    }
+}
+
+static int64_t bench_run (struct bench_data *bd, const char *path, bool encode)
+{
+    int64_t out_length = 0, in_rover = 0;
+    size_t i, pieces = (bd->size + BENCH_PIECE - 1) / BENCH_PIECE;
+
+    if (strcmp(path, "threaded") == 0)
+    {
+        if (encode)
+            return encode_ascii85_mt(bd->raw, bd->size, bd->enc, (bd->size / 4 + 1) * 5, 0);
+        return decode_ascii85_mt(bd->enc, bd->enc_length, bd->dec, bd->size, 0);
+    }
+    for (i = 0; i < pieces; i++)
+    {
+        int32_t n = (int32_t )((i + 1 < pieces) ? BENCH_PIECE : bd->size - i * BENCH_PIECE);
+        int32_t r;
+
+        if (encode)
+        {
+            r = encode_ascii85(bd->raw + i * BENCH_PIECE, n, bd->enc + out_length, INT32_MAX);
+            bd->piece_length[i] = r;
+        }
+        else
+        {
+            r = decode_ascii85(bd->enc + in_rover, bd->piece_length[i], bd->dec + out_length, INT32_MAX);
+            in_rover += bd->piece_length[i];
+        }
+        if (r < 0)
+            return r;
+        out_length += r;
+    }
+    return out_length;
+}
+
+/* best of a few rounds of at least min_time each: throughput only suffers from noise */
+static double bench_measure (struct bench_data *bd, const char *path, bool encode, double min_time)
+{
+    double best = 0.0;
+    int round;
+
+    ascii85_simd_enabled = (strcmp(path, "scalar") != 0);
+    for (round = 0; round < 5; round++)
+    {
+        double start = bench_now(), elapsed;
+        long iterations = 0;
+
+        do {
+            if (bench_run(bd, path, encode) < 0)
+            {
+                ascii85_simd_enabled = true;
+                return -1.0;
+            }
+            iterations++;
+            elapsed = bench_now() - start;
+        } while (elapsed < min_time);
+
+        if ((double )bd->size * iterations / elapsed / 1e6 > best)
+            best = (double )bd->size * iterations / elapsed / 1e6;
+    }
+    ascii85_simd_enabled = true;
+
+    return best;
+}
+
+static int bench_load_baseline (const char *path, struct bench_result **results, size_t *count)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    size_t size = 0;
+
+    *results = NULL;
+    *count = 0;
+    if (f == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        struct bench_result r;
+
+        if (sscanf(line, " {\"path\": \"%15[^\"]\", \"op\": \"%15[^\"]\", \"dist\": \"%15[^\"]\", \"size\": %zu, \"mbps\": %lf",
+                   r.path, r.op, r.dist, &r.size, &r.mbps) != 5)
+            continue;
+        if (*count == size)
+        {
+            struct bench_result *tmp = realloc(*results, (size ? size * 2 : 64) * sizeof(*tmp));
+
+            if (tmp == NULL)
+            {
+                fclose(f);
+                return -1;
+            }
+            *results = tmp;
+            size = (size ? size * 2 : 64);
+        }
+        (*results)[(*count)++] = r;
+    }
+    fclose(f);
+    return 0;
+}
+
+/* run all benchmarks; with a baseline, the result is 1 if any got slower by more than threshold % */
+static int bench (char *arg0, const char *baseline_path, double threshold)
+{
+    static const char *dists[] = { "random", "zero", "text" };
+    static const size_t sizes[] = { 1024, 65536, 1 << 20, 16 << 20 };
+    // there is no SIMD encoder, the scalar one is what the SIMD build runs
+    static const struct { const char *path; bool encode; } paths[] = {
+        { "scalar", true }, { "threaded", true },
+        { "scalar", false }, { "simd", false }, { "threaded", false },
+    };
+    struct bench_result *baseline = NULL;
+    size_t baseline_count = 0, d, s, p, i;
+    const char *sep = "";
+    int ret = 0;
+
+    if (baseline_path != NULL && bench_load_baseline(baseline_path, &baseline, &baseline_count) != 0)
+    {
+        perror(baseline_path);
+        return 1;
+    }
+
+    printf("{\n  \"tool\": \"ascii85\",\n  \"simd\": %s,\n  \"results\": [", ascii85_cpu_has_avx2() ? "true" : "false");
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        struct bench_data bd;
+
+        bd.size = sizes[s];
+        bd.raw = malloc(bd.size);
+        bd.enc = malloc((bd.size / 4 + 1) * 5);
+        bd.dec = malloc(bd.size);
+        bd.piece_length = malloc(((bd.size + BENCH_PIECE - 1) / BENCH_PIECE) * sizeof(int32_t));
+        if (bd.raw == NULL || bd.enc == NULL || bd.dec == NULL || bd.piece_length == NULL)
+        {
+            perror("malloc");
+            return 1;
+        }
+
+        for (d = 0; d < sizeof(dists) / sizeof(dists[0]); d++)
+        {
+            bench_fill(bd.raw, bd.size, dists[d]);
+            // also sets up the pieces for decoding, and checks the round trip
+            bd.enc_length = bench_run(&bd, "scalar", true);
+            if (bd.enc_length < 0 || bench_run(&bd, "threaded", false) != (int64_t )bd.size
+                || memcmp(bd.raw, bd.dec, bd.size) != 0)
+            {
+                fprintf(stderr, "%s: round trip of %zu bytes %s data failed\n", arg0, bd.size, dists[d]);
+                return 1;
+            }
+
+            for (p = 0; p < sizeof(paths) / sizeof(paths[0]); p++)
+            {
+                struct bench_result r;
+
+                snprintf(r.path, sizeof(r.path), "%s", paths[p].path);
+                snprintf(r.op, sizeof(r.op), "%s", paths[p].encode ? "encode" : "decode");
+                snprintf(r.dist, sizeof(r.dist), "%s", dists[d]);
+                r.size = bd.size;
+                r.mbps = bench_measure(&bd, r.path, paths[p].encode, 0.02);
+
+                printf("%s\n    {\"path\": \"%s\", \"op\": \"%s\", \"dist\": \"%s\", \"size\": %zu, \"mbps\": %.1f}",
+                       sep, r.path, r.op, r.dist, r.size, r.mbps);
+                sep = ",";
+                fflush(stdout);
+
+                for (i = 0; i < baseline_count; i++)
+                {
+                    const struct bench_result *b = &baseline[i];
+
+                    if (strcmp(b->path, r.path) == 0 && strcmp(b->op, r.op) == 0 && strcmp(b->dist, r.dist) == 0
+                        && b->size == r.size && r.mbps < b->mbps * (1.0 - threshold / 100.0))
+                    {
+                        fprintf(stderr, "%s: regression: %s %s %s %zu bytes: %.1f MB/s, baseline %.1f MB/s (%+.1f%%)\n",
+                                arg0, r.path, r.op, r.dist, r.size, r.mbps, b->mbps, (r.mbps / b->mbps - 1.0) * 100.0);
+                        ret = 1;
+                    }
+                }
+            }
+        }
+        free(bd.raw);
+        free(bd.enc);
+        free(bd.dec);
+        free(bd.piece_length);
+    }
+    printf("\n  ]\n}\n");
+
+    free(baseline);
+    return ret;
+}
+
+static int endecode_file (char *arg0, struct options *opts, const char *path)
+{
+    struct stat st;
+    uint8_t *map = NULL;
+    int fd, ret;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        perror(path);
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+    if (st.st_size > 0)
+    {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            perror("mmap");
+            close(fd);
+            return 1;
+        }
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    if (opts->crc || opts->tolerant)
+    {
+        // these work on the data as a whole
+        ret = endecode(arg0, opts, (map != NULL ? map : (const uint8_t *)""), st.st_size);
+    }
+    else
+    {
+        ret = endecode_mapped(arg0, opts, (map != NULL ? map : (const uint8_t *)""), st.st_size);
+    }
+
+    if (map != NULL)
+        munmap(map, st.st_size);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    char *out_enc;
+    uint8_t *out_dec;
+    size_t buflen;
+    int32_t siz_enc, siz_dec;
+    bool doEncode = false, doDecode = false, doFrames = false, doBench = false;
+    const char *path = NULL, *baseline = NULL;
+    double threshold = 10.0;
+    struct options opts;
+    int opt;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.threads = 1;
+    opts.variant = &base85_ascii85;
+
+    if (argc == 0)
+        exit(1);
+
+    while ((opt = getopt(argc, argv, "edwt:l:aV:scf:bC:T:h")) != -1) {
+        switch (opt) {
+        case 'e':
+            doEncode = true;
+            break;
+        case 'd':
+            doDecode = true;
+            break;
+        case 'w':
+            doDecode = true;
+            opts.tolerant = true;
+            break;
+        case 't':
+            opts.threads = strtoul(optarg, NULL, 10);
+            break;
+        case 'l': {
+            char *end;
+            long width = strtol(optarg, &end, 10);
+
+            // the output sizes allow at most one line break per two chars
+            if (end == optarg || *end != '\0' || width < 0 || width == 1 || width > INT32_MAX) {
+                fprintf(stderr, "%s: line width must be 0 or at least 2\n", argv[0]);
+                return 1;
+            }
+            opts.wrap.line_width = (int32_t )width;
+            break;
+        }
+        case 'a':
+            opts.wrap.framed = true;
+            break;
+        case 's':
+            doFrames = true;
+            break;
+        case 'c':
+            opts.crc = true;
+            break;
+        case 'f':
+            path = optarg;
+            break;
+        case 'b':
+            doBench = true;
+            break;
+        case 'C':
+            baseline = optarg;
+            break;
+        case 'T':
+            threshold = strtod(optarg, NULL);
+            break;
+        case 'V': {
+            const struct base85_variant *variants[] = { &base85_ascii85, &base85_z85, &base85_rfc1924, &base85_btoa };
+            size_t i;
+
+            opts.variant = NULL;
+            for (i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+                if (strcmp(optarg, variants[i]->name) == 0)
+                    opts.variant = variants[i];
+            }
+            if (opts.variant == NULL) {
+                fprintf(stderr, "%s: unknown variant `%s'\n", argv[0], optarg);
+                return 1;
+            }
+            break;
+        }
+        default:
+            print_usage_and_exit(argv[0]);
+        }
+    }
+
+    if (doEncode && doDecode)
+        print_usage_and_exit(argv[0]);
+    if (doBench) {
+        if (doEncode || doDecode || doFrames || optind != argc)
+            print_usage_and_exit(argv[0]);
+        return bench(argv[0], baseline, threshold);
+    }
+    if (doFrames) {
+        if (doEncode || doDecode || optind < argc - 1)
+            print_usage_and_exit(argv[0]);
+        return decode_frames(argv[0], (optind == argc - 1 ? argv[optind] : NULL), opts.crc);
+    }
+    if (opts.variant != &base85_ascii85 && (opts.tolerant || is_wrapped(&opts) || opts.crc)) {
+        fprintf(stderr, "%s: -w, -l, -a and -c are only available for ascii85\n", argv[0]);
+        return 1;
+    }
+    if (opts.crc && (opts.tolerant || is_wrapped(&opts))) {
+        fprintf(stderr, "%s: -c can not be combined with -w, -l or -a\n", argv[0]);
+        return 1;
+    }
+    if (doEncode || doDecode) {
+        uint8_t *inp;
+        int ret;
+
+        if (optind < argc - 1 || (path != NULL && optind != argc))
+            print_usage_and_exit(argv[0]);
+        opts.encode = doEncode;
+        if (path != NULL)
+            return endecode_file(argv[0], &opts, path);
+        if (optind == argc - 1)
+            return endecode(argv[0], &opts, (uint8_t *) argv[optind], strlen(argv[optind]));
+        if (doEncode && opts.variant == &base85_ascii85 && !opts.crc && (opts.threads == 1 || is_wrapped(&opts)))
+            return encode_stream(argv[0], &opts, STDIN_FILENO);
+
+        inp = read_all(STDIN_FILENO, &buflen);
+        if (inp == NULL) {
+            perror("read");
+            return 1;
+        }
+        if (doDecode && opts.variant == &base85_ascii85 && !opts.tolerant && !opts.crc && opts.threads == 1)
+            ret = decode_inplace(argv[0], &inp, buflen);
+        else
+            ret = endecode(argv[0], &opts, inp, buflen);
+        free(inp);
+        return ret;
+    }
+
+#if ENDECODE_NUL_AS_Z
+    printf("Encoding NUL characters won't work from cmdline!\n");
+#endif
+    if (optind != argc - 1 || path != NULL)
+        print_usage_and_exit(argv[0]);
+
+    buflen = strlen(argv[optind]);
+    out_enc = malloc(ascii85_encoded_length((uint8_t *) argv[optind], buflen) + 1);
+    if (out_enc == NULL) {
+        perror("malloc");
+        return 1;
+    }
+    siz_enc = encode_ascii85((uint8_t *) argv[optind], buflen, out_enc,
+                             ascii85_encoded_length((uint8_t *) argv[optind], buflen));
+    printf("Encoded: \"%.*s\"\n", siz_enc, (char *) out_enc);
+    out_dec = malloc(ascii85_decoded_length(out_enc, siz_enc, NULL) + 1);
+    if (out_dec == NULL) {
+        perror("malloc");
+        free(out_enc);
+        return 1;
+    }
+    siz_dec = decode_ascii85(out_enc, siz_enc, out_dec, ascii85_decoded_length(out_enc, siz_enc, NULL));
     printf("Decoded: \"%.*s\"\n", siz_dec, (char *) out_dec);
 
     if ((int32_t) buflen == siz_dec &&
-        memcmp(out_dec, argv[1], buflen) == 0)
+        memcmp(out_dec, argv[optind], buflen) == 0)
     {
         printf("%s: Ok!\n", argv[0]);
     } else printf("%s: FAIL!\n", argv[0]);
 
+    free(out_enc);
+    free(out_dec);
     return 0;
 }
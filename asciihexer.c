@@ -1,46 +1,1235 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(ASCIIHEXER_NO_SIMD)
+#include <immintrin.h>
+#define ASCIIHEXER_SIMD 1
+#endif
 
 #define ASCII_HEXLEN 3
 
+/* The formats are produced by one pass over the input in blocks of HEX_BLOCK bytes. For every
+ * format a template describes the output of a block: per output char either a literal or the
+ * high/low nibble of one of the input bytes. SSSE3 applies a template with one shuffle per
+ * nibble and output vector; without it a table lookup per char does the same. Output goes
+ * through large buffers, there is no printf per char.
+ */
+#define HEX_BLOCK 16
+#define HEX_TMPL_MAX 160
+#define HEX_TMPL_VECS (HEX_TMPL_MAX / 16)
+#define HEX_LIT 0xFF
+#define HEX_OUT_SIZE (1 << 20)
+#define HEX_IN_SIZE (1 << 16)
+#define HEX_WORD_FMTS 8
+
+static const char hexDigits[16] = "0123456789ABCDEF";
+static const char hexDigitsLower[16] = "0123456789abcdef";
 
-static void defaultHexOut(char *text) {
-  int i;
+struct hexTmpl {
+  int len;
+  const char *digits;        /* hexDigits unless set before tmplDone */
+  uint8_t src[HEX_TMPL_MAX]; /* (input byte << 1) | low nibble, or HEX_LIT */
+  char lit[HEX_TMPL_MAX];
+#ifdef ASCIIHEXER_SIMD
+  __m128i mh[HEX_TMPL_VECS]; /* pshufb masks: high nibble digits .. */
+  __m128i ml[HEX_TMPL_VECS]; /* .. low nibble digits .. */
+  __m128i lv[HEX_TMPL_VECS]; /* .. and the literals in between */
+#endif
+};
+
+struct hexSink {
+  int fd;       /* -1: kept in memory until the end; else stdout or a spool file */
+  char *buf;
   size_t len;
+  size_t cap;
+};
+
+struct hexFmt {
+  struct hexTmpl tmpl;
+  void (*byteOut)(struct hexSink *s, uint8_t c, uint64_t i); /* the same for a single byte */
+  struct hexWords *words;    /* a word format instead, fed on its own */
+  struct hexSink sink;
+};
 
-  for (i = 0; i < (len = strlen(text)); i++) {
-    printf("0x%X%c", text[i], (i == len-1 ? '\n' : ' '));
+#ifdef ASCIIHEXER_SIMD
+static bool useSsse3;
+static uint8_t hexCompactLut[256][8]; /* pshufb indices of the set bits of a mask */
+#endif
+
+static void hexCompactInit(void) {
+#ifdef ASCIIHEXER_SIMD
+  int m, b, k;
+
+  for (m = 0; m < 256; m++) {
+    for (b = 0, k = 0; b < 8; b++)
+      if (m & (1 << b))
+        hexCompactLut[m][k++] = (uint8_t)b;
+    for (; k < 8; k++)
+      hexCompactLut[m][k] = 0x80;
   }
+#endif
 }
 
-static void dwordHexOut(char *text) {
-  int i;
-  size_t len;
+static void tmplLit(struct hexTmpl *t, const char *s) {
+  for (; *s; s++) {
+    t->src[t->len] = HEX_LIT;
+    t->lit[t->len++] = *s;
+  }
+}
+
+static void tmplByte(struct hexTmpl *t, int j) {
+  t->src[t->len] = (uint8_t)(j << 1);
+  t->lit[t->len++] = 0;
+  t->src[t->len] = (uint8_t)((j << 1) | 1);
+  t->lit[t->len++] = 0;
+}
+
+static void tmplDone(struct hexTmpl *t) {
+#ifdef ASCIIHEXER_SIMD
+  uint8_t mh[HEX_TMPL_MAX], ml[HEX_TMPL_MAX];
+  char lv[HEX_TMPL_MAX];
+  int p;
+#endif
+
+  if (t->digits == NULL)
+    t->digits = hexDigits;
+#ifdef ASCIIHEXER_SIMD
+  for (p = 0; p < HEX_TMPL_MAX; p++) {
+    bool lit = (p >= t->len || t->src[p] == HEX_LIT);
+
+    mh[p] = (!lit && !(t->src[p] & 1)) ? (t->src[p] >> 1) : 0x80;
+    ml[p] = (!lit && (t->src[p] & 1)) ? (t->src[p] >> 1) : 0x80;
+    lv[p] = (p < t->len && lit) ? t->lit[p] : 0;
+  }
+  for (p = 0; p < HEX_TMPL_VECS; p++) {
+    t->mh[p] = _mm_loadu_si128((const __m128i *)&mh[p * 16]);
+    t->ml[p] = _mm_loadu_si128((const __m128i *)&ml[p * 16]);
+    t->lv[p] = _mm_loadu_si128((const __m128i *)&lv[p * 16]);
+  }
+#endif
+}
+
+#ifdef ASCIIHEXER_SIMD
+__attribute__((target("ssse3")))
+static void tmplApplySsse3(const struct hexTmpl *t, const uint8_t *in, char *out) {
+  const __m128i digits = _mm_loadu_si128((const __m128i *)t->digits);
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_loadu_si128((const __m128i *)in);
+  __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibble));
+  __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+  int k;
+
+  for (k = 0; k < (t->len + 15) / 16; k++) {
+    __m128i o = _mm_or_si128(_mm_shuffle_epi8(hi, t->mh[k]), _mm_shuffle_epi8(lo, t->ml[k]));
+
+    _mm_storeu_si128((__m128i *)&out[k * 16], _mm_or_si128(o, t->lv[k]));
+  }
+}
+#endif
+
+/* writes t->len chars to out, rounded up to 16 with SSSE3 */
+static void tmplApply(const struct hexTmpl *t, const uint8_t *in, char *out) {
+  int p;
+
+#ifdef ASCIIHEXER_SIMD
+  if (useSsse3) {
+    tmplApplySsse3(t, in, out);
+    return;
+  }
+#endif
+  for (p = 0; p < t->len; p++) {
+    uint8_t src = t->src[p];
+
+    if (src == HEX_LIT)
+      out[p] = t->lit[p];
+    else
+      out[p] = t->digits[(src & 1) ? (in[src >> 1] & 0x0F) : (in[src >> 1] >> 4)];
+  }
+}
+
+#ifdef ASCIIHEXER_SIMD
+/* The high digits of the bytes below 0x10 (if any) are dropped from each vector and the rest
+ * is compacted, 8 chars at a time. */
+__attribute__((target("ssse3")))
+static int tmplApplyShortSsse3(const struct hexTmpl *t, const uint8_t *in, char *out) {
+  const __m128i digits = _mm_loadu_si128((const __m128i *)t->digits);
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  __m128i v = _mm_loadu_si128((const __m128i *)in);
+  __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibble));
+  __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+  __m128i small = _mm_cmpeq_epi8(_mm_max_epu8(v, nibble), nibble);
+  int k, len = 0;
+
+  if (_mm_movemask_epi8(small) == 0) {
+    for (k = 0; k < (t->len + 15) / 16; k++) {
+      __m128i o = _mm_or_si128(_mm_shuffle_epi8(hi, t->mh[k]), _mm_shuffle_epi8(lo, t->ml[k]));
+
+      _mm_storeu_si128((__m128i *)&out[k * 16], _mm_or_si128(o, t->lv[k]));
+    }
+    return t->len;
+  }
+  for (k = 0; k < (t->len + 15) / 16; k++) {
+    __m128i o = _mm_or_si128(_mm_shuffle_epi8(hi, t->mh[k]), _mm_shuffle_epi8(lo, t->ml[k]));
+    unsigned keep = ~(unsigned)_mm_movemask_epi8(_mm_shuffle_epi8(small, t->mh[k])) & 0xFFFF;
+
+    o = _mm_or_si128(o, t->lv[k]);
+    if (t->len - k * 16 < 16)
+      keep &= (1u << (t->len - k * 16)) - 1;
+    _mm_storel_epi64((__m128i *)&out[len],
+                     _mm_shuffle_epi8(o, _mm_loadl_epi64((const __m128i *)hexCompactLut[keep & 0xFF])));
+    len += __builtin_popcount(keep & 0xFF);
+    _mm_storel_epi64((__m128i *)&out[len],
+                     _mm_shuffle_epi8(_mm_srli_si128(o, 8), _mm_loadl_epi64((const __m128i *)hexCompactLut[keep >> 8])));
+    len += __builtin_popcount(keep >> 8);
+  }
+  return len;
+}
+#endif
+
+/* tmplApply for the "%X" formats: no high digit for the bytes below 0x10. Returns the length,
+ * writes up to t->len chars rounded up to 16. */
+static int tmplApplyShort(const struct hexTmpl *t, const uint8_t *in, char *out) {
+  int j, p, len = 0;
+  uint8_t min = 0xFF;
+
+#ifdef ASCIIHEXER_SIMD
+  if (useSsse3)
+    return tmplApplyShortSsse3(t, in, out);
+#endif
+  for (j = 0; j < HEX_BLOCK; j++)
+    min = (in[j] < min ? in[j] : min);
+  if (min >= 0x10) {
+    tmplApply(t, in, out);
+    return t->len;
+  }
+  for (p = 0; p < t->len; p++) {
+    uint8_t src = t->src[p];
+
+    if (src == HEX_LIT)
+      out[len++] = t->lit[p];
+    else if (src & 1)
+      out[len++] = t->digits[in[src >> 1] & 0x0F];
+    else if (in[src >> 1] >= 0x10)
+      out[len++] = t->digits[in[src >> 1] >> 4];
+  }
+  return len;
+}
+
+static void sinkFlush(struct hexSink *s) {
+  size_t done = 0;
+
+  while (s->fd >= 0 && done < s->len) {
+    ssize_t n = write(s->fd, s->buf + done, s->len - done);
+
+    if (n < 0) {
+      perror("write");
+      exit(1);
+    }
+    done += n;
+  }
+  if (s->fd >= 0)
+    s->len = 0;
+}
+
+/* room for n more chars (plus slack for full vector stores) */
+static char *sinkReserve(struct hexSink *s, size_t n) {
+  if (s->len + n + 16 > s->cap)
+    sinkFlush(s);
+  if (s->len + n + 16 > s->cap) {
+    size_t cap = (s->cap ? s->cap * 2 : HEX_OUT_SIZE);
+
+    while (s->len + n + 16 > cap)
+      cap *= 2;
+    s->buf = realloc(s->buf, cap);
+    if (s->buf == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+    s->cap = cap;
+  }
+  return s->buf + s->len;
+}
+
+static void sinkPut(struct hexSink *s, const char *str, size_t n) {
+  memcpy(sinkReserve(s, n), str, n);
+  s->len += n;
+}
+
+/* the original formats print "%X": no leading zero */
+static void putDigits(struct hexSink *s, uint8_t c) {
+  char *out = sinkReserve(s, 2);
+
+  if (c >= 0x10)
+    *out++ = hexDigits[c >> 4];
+  *out++ = hexDigits[c & 0x0F];
+  s->len = out - s->buf;
+}
+
+/* "0x41 0x42 0x43" */
+static void defaultByteOut(struct hexSink *s, uint8_t c, uint64_t i) {
+  sinkPut(s, (i ? " 0x" : "0x"), (i ? 3 : 2));
+  putDigits(s, c);
+}
+
+static void defaultHexOut(struct hexTmpl *t) {
+  int j;
 
-  for (i = 0; i < (len = strlen(text)); i++) {
-    printf("%s%X%s", (i % 4 == 0 ? (i == 0 ? "0x" : " 0x") : ""), text[i], (i == len-1 ? "\n" : ""));
+  for (j = 0; j < HEX_BLOCK; j++) {
+    tmplLit(t, " 0x");
+    tmplByte(t, j);
   }
 }
 
-static void strHexOut(char *text) {
-  int i;
+/* "0x41424344 0x45" */
+static void dwordByteOut(struct hexSink *s, uint8_t c, uint64_t i) {
+  if (i % 4 == 0)
+    sinkPut(s, (i ? " 0x" : "0x"), (i ? 3 : 2));
+  putDigits(s, c);
+}
+
+static void dwordHexOut(struct hexTmpl *t) {
+  int j;
+
+  for (j = 0; j < HEX_BLOCK; j++) {
+    if (j % 4 == 0)
+      tmplLit(t, " 0x");
+    tmplByte(t, j);
+  }
+}
+
+/* "0x4142434445" */
+static void strByteOut(struct hexSink *s, uint8_t c, uint64_t i) {
+  if (i == 0)
+    sinkPut(s, "0x", 2);
+  putDigits(s, c);
+}
+
+static void strHexOut(struct hexTmpl *t) {
+  int j;
+
+  for (j = 0; j < HEX_BLOCK; j++)
+    tmplByte(t, j);
+}
+
+/* Word formats ("0x4241 0x4443" for -g u16le) and the elements of the C source output: u8 to
+ * u64 elements of either byte order. Byte order is only the order of a template's sources, the
+ * swap comes with the nibble shuffles for free. The separators of a block depend on its place
+ * in the line pattern, which repeats after lcm(line, block) elements, so there is a template
+ * per place. The first block and a short tail go through wordsElem.
+ */
+#define WORDS_LINE_MAX 4096
+
+struct hexWords {
+  struct hexTmpl *tmpls;     /* per block place in the line pattern */
+  int phases;
+  int width;                 /* bytes per element */
+  bool big;                  /* big endian elements */
+  int perLine;               /* elements per line, 0 for a single line */
+  const char *sep;           /* between elements .. */
+  const char *lineSep;       /* .. and lines */
+  const char *prefix;        /* of every element */
+  const char *digits;
+  struct hexSink *out;
+  uint64_t i;                /* input bytes done */
+  uint8_t carry[HEX_BLOCK];  /* a started block */
+  size_t carryLen;
+};
+
+/* "u8", "u16", "u32" or "u64", optionally followed by "le" (default) or "be" */
+static bool wordsParse(const char *spec, int *width, bool *big) {
+  char *end;
+  unsigned long bits = (spec[0] == 'u' ? strtoul(spec + 1, &end, 10) : 0);
+
+  if (bits != 8 && bits != 16 && bits != 32 && bits != 64)
+    return false;
+  *width = (int)(bits / 8);
+  *big = (strcmp(end, "be") == 0);
+  return (*end == '\0' || strcmp(end, "le") == 0 || *big);
+}
+
+static const char *wordsSep(const struct hexWords *w, uint64_t elem) {
+  if (elem == 0)
+    return "";
+  if (w->perLine > 0 && elem % w->perLine == 0)
+    return w->lineSep;
+  return w->sep;
+}
+
+static void wordsInit(struct hexWords *w) {
+  int per = HEX_BLOCK / w->width, a = w->perLine, b = per, k, e, j;
+
+  while (b != 0) {
+    int r = a % b;
+
+    a = b;
+    b = r;
+  }
+  w->phases = (w->perLine > 0 ? w->perLine / a : 1);
+  if (posix_memalign((void **)&w->tmpls, 16, w->phases * sizeof(*w->tmpls)) != 0) {
+    perror("posix_memalign");
+    exit(1);
+  }
+  memset(w->tmpls, 0, w->phases * sizeof(*w->tmpls));
+  for (k = 0; k < w->phases; k++) {
+    struct hexTmpl *t = &w->tmpls[k];
+
+    for (e = 0; e < per; e++) {
+      /* the first element of all is never in a template: keep the index off 0 */
+      tmplLit(t, wordsSep(w, (uint64_t)(w->phases + k) * per + e));
+      tmplLit(t, w->prefix);
+      for (j = 0; j < w->width; j++)
+        tmplByte(t, e * w->width + (w->big ? j : w->width - 1 - j));
+    }
+    t->digits = w->digits;
+    tmplDone(t);
+  }
+}
+
+/* one element at elem, a short one is zero padded */
+static void wordsElem(struct hexWords *w, const uint8_t *in, size_t n, uint64_t elem) {
+  const char *sep = wordsSep(w, elem);
+  uint8_t v[8] = { 0 };
+  char *p;
+  int j;
+
+  memcpy(v, in, n);
+  sinkPut(w->out, sep, strlen(sep));
+  sinkPut(w->out, w->prefix, strlen(w->prefix));
+  p = sinkReserve(w->out, 2 * w->width);
+  for (j = 0; j < w->width; j++) {
+    uint8_t byte = v[w->big ? j : w->width - 1 - j];
+
+    *p++ = w->digits[byte >> 4];
+    *p++ = w->digits[byte & 0x0F];
+  }
+  w->out->len = p - w->out->buf;
+}
+
+static void wordsBlock(struct hexWords *w, const uint8_t *in) {
+  int e;
+
+  if (w->i == 0) {
+    for (e = 0; e < HEX_BLOCK / w->width; e++)
+      wordsElem(w, in + e * w->width, w->width, e);
+  } else {
+    const struct hexTmpl *t = &w->tmpls[(w->i / HEX_BLOCK) % w->phases];
+
+    tmplApply(t, in, sinkReserve(w->out, t->len));
+    w->out->len += t->len;
+  }
+  w->i += HEX_BLOCK;
+}
+
+static void wordsFeed(struct hexWords *w, const uint8_t *in, size_t n) {
+  while (n > 0) {
+    if (w->carryLen > 0 || n < HEX_BLOCK) {
+      size_t k = (n < HEX_BLOCK - w->carryLen ? n : HEX_BLOCK - w->carryLen);
+
+      memcpy(w->carry + w->carryLen, in, k);
+      w->carryLen += k;
+      in += k;
+      n -= k;
+      if (w->carryLen == HEX_BLOCK) {
+        wordsBlock(w, w->carry);
+        w->carryLen = 0;
+      }
+    } else {
+      wordsBlock(w, in);
+      in += HEX_BLOCK;
+      n -= HEX_BLOCK;
+    }
+  }
+}
+
+/* the elements of a started block */
+static void wordsTail(struct hexWords *w) {
+  size_t pos;
+
+  for (pos = 0; pos < w->carryLen; pos += w->width)
+    wordsElem(w, w->carry + pos, (w->carryLen - pos < (size_t)w->width ? w->carryLen - pos : (size_t)w->width),
+              (w->i + pos) / w->width);
+  w->i += w->carryLen;
+  w->carryLen = 0;
+  free(w->tmpls);
+}
+
+/* A block can use the templates if it does not start a line or dword group. */
+static bool blockFits(uint64_t i) {
+  return (i != 0 && i % 4 == 0);
+}
+
+/* feed the next n bytes of the input (at offset *i) to all formats */
+static void hexFeed(struct hexFmt *fmts, int count, const uint8_t *in, size_t n, uint64_t *i) {
+  size_t pos = 0;
+  int f, bytewise = 0;
+
+  for (f = 0; f < count; f++) {
+    if (fmts[f].words != NULL)
+      wordsFeed(fmts[f].words, in, n);
+    else
+      bytewise++;
+  }
+  if (bytewise == 0) {
+    *i += n;
+    return;
+  }
+  while (pos < n) {
+    if (n - pos >= HEX_BLOCK && blockFits(*i)) {
+      for (f = 0; f < count; f++) {
+        struct hexSink *s = &fmts[f].sink;
+
+        if (fmts[f].words != NULL)
+          continue;
+        s->len += tmplApplyShort(&fmts[f].tmpl, in + pos, sinkReserve(s, fmts[f].tmpl.len));
+      }
+      pos += HEX_BLOCK;
+      *i += HEX_BLOCK;
+    } else {
+      for (f = 0; f < count; f++)
+        if (fmts[f].words == NULL)
+          fmts[f].byteOut(&fmts[f].sink, in[pos], *i);
+      pos++;
+      (*i)++;
+    }
+  }
+}
+
+static bool hexWordsFeed(void *ctx, const uint8_t *in, size_t n) {
+  wordsFeed(ctx, in, n);
+  return true;
+}
+
+struct hexEnc {
+  struct hexFmt *fmts;
+  int count;
+  uint64_t i;
+};
+
+static bool hexEncFeed(void *ctx, const uint8_t *in, size_t n) {
+  struct hexEnc *e = ctx;
+
+  hexFeed(e->fmts, e->count, in, n, &e->i);
+  return true;
+}
+
+/* pass a whole input to feed: regular files are mapped, anything else is read in HEX_IN_SIZE
+ * chunks; stops early if feed returns false */
+static bool readInput(int fd, bool (*feed)(void *ctx, const uint8_t *in, size_t n), void *ctx) {
+  static uint8_t in[HEX_IN_SIZE];
+  struct stat st;
+  ssize_t n;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    uint8_t *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map != MAP_FAILED) {
+      bool ok;
+
+      madvise(map, st.st_size, MADV_SEQUENTIAL);
+      ok = feed(ctx, map, st.st_size);
+      munmap(map, st.st_size);
+      return ok;
+    }
+  }
+  while ((n = read(fd, in, sizeof(in))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("read");
+      exit(1);
+    }
+    if (!feed(ctx, in, n))
+      return false;
+  }
+  return true;
+}
+
+/* end the lines and write out the formats in order */
+static void hexFinish(struct hexFmt *fmts, int count, uint64_t total) {
+  int f;
+
+  for (f = 0; f < count; f++) {
+    struct hexSink *s = &fmts[f].sink;
+
+    if (fmts[f].words != NULL)
+      wordsTail(fmts[f].words);
+    if (total > 0)
+      sinkPut(s, "\n", 1);
+    if (s->fd < 0)
+      s->fd = STDOUT_FILENO;
+    sinkFlush(s);
+    if (s->fd != STDOUT_FILENO) {
+      /* spooled: copy it behind the formats before it */
+      int spool = s->fd;
+      ssize_t n;
+
+      s->fd = STDOUT_FILENO;
+      lseek(spool, 0, SEEK_SET);
+      while ((n = read(spool, s->buf, s->cap)) > 0) {
+        s->len = n;
+        sinkFlush(s);
+      }
+      close(spool);
+    }
+    free(s->buf);
+  }
+}
+
+/* Reverse mode: hex text back to bytes. Digits pair up into bytes; "0x"/"\x" prefixes, white
+ * space, ',' and '"' in between are skipped, so the output of -x, -q and of aes (plain and
+ * C string) decodes. A run of digits must have an even length, except for a single digit
+ * (-x prints bytes < 0x10 that way), which is a byte of its own. -s and -w print bytes < 0x10
+ * with one digit inside a run, which can not be told apart from the pairs around it: such
+ * output does not decode, and mostly not even with an error.
+ *
+ * The digits are collected in a stage buffer and converted in bulk. Blocks of 16 chars are
+ * classified with SSE compares into bit masks; pure digit blocks are copied, blocks whose runs
+ * are all even are compacted into the stage with shuffles. Everything else, including the
+ * first invalid char, goes through the per char state machine.
+ */
+#define HEX_STAGE (1 << 16)
+
+struct hexDec {
+  struct hexSink *out;
+  uint64_t offset;    /* input offset of the next char */
+  int64_t error;      /* offset of the first invalid char, or -1 */
+  int run;            /* length of the current digit run */
+  bool backslash;     /* the previous char was '\' */
   size_t len;
- 
-  for (i = 0; i < (len = strlen(text)); i++) {
-    printf("%s%X%s", (i == 0 ? "0x" : ""), text[i], (i == len-1 ? "\n" : ""));
+  char stage[HEX_STAGE + 32];
+};
+
+static inline bool hexIsDigit(uint8_t c) {
+  return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static inline bool hexIsSep(uint8_t c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f' || c == ',' || c == '"';
+}
+
+/* '0'-'9' -> 0-9, 'A'-'F' and 'a'-'f' -> 10-15 (bit 6 is set for the letters) */
+static inline uint8_t hexVal(uint8_t c) {
+  return (c & 0x0F) + 9 * ((c >> 6) & 1);
+}
+
+#ifdef ASCIIHEXER_SIMD
+__attribute__((target("ssse3")))
+static size_t hexPairsSsse3(const char *in, size_t pairs, uint8_t *out) {
+  const __m128i nibble = _mm_set1_epi8(0x0F), one = _mm_set1_epi8(1);
+  const __m128i weights = _mm_set1_epi16(0x0110); /* high digit * 16 + low digit */
+  size_t k;
+
+  for (k = 0; k + 8 <= pairs; k += 8) {
+    __m128i c = _mm_loadu_si128((const __m128i *)&in[k * 2]);
+    __m128i letter = _mm_and_si128(_mm_srli_epi16(c, 6), one);
+    __m128i v = _mm_add_epi8(_mm_add_epi8(_mm_and_si128(c, nibble), _mm_slli_epi16(letter, 3)), letter);
+    __m128i b = _mm_maddubs_epi16(v, weights);
+
+    _mm_storel_epi64((__m128i *)&out[k], _mm_packus_epi16(b, b));
+  }
+  return k;
+}
+#endif
+
+/* convert the complete pairs in the stage, an unpaired last digit stays */
+static void hexDecFlush(struct hexDec *d) {
+  size_t pairs = d->len / 2, k = 0;
+  uint8_t *out = (uint8_t *)sinkReserve(d->out, pairs);
+
+#ifdef ASCIIHEXER_SIMD
+  if (useSsse3)
+    k = hexPairsSsse3(d->stage, pairs, out);
+#endif
+  for (; k < pairs; k++)
+    out[k] = (uint8_t)((hexVal(d->stage[k * 2]) << 4) | hexVal(d->stage[k * 2 + 1]));
+  d->out->len += pairs;
+  if (d->len & 1)
+    d->stage[0] = d->stage[d->len - 1];
+  d->len &= 1;
+}
+
+/* the current run ends: an odd one must be a single digit, which gets a leading '0' */
+static bool hexDecEndRun(struct hexDec *d) {
+  if (d->run & 1) {
+    if (d->run != 1) {
+      d->error = d->offset - 1;
+      return false;
+    }
+    d->stage[d->len] = d->stage[d->len - 1];
+    d->stage[d->len - 1] = '0';
+    d->len++;
+  }
+  d->run = 0;
+  return true;
+}
+
+static bool hexDecChar(struct hexDec *d, uint8_t c) {
+  if (d->backslash && (c | 0x20) != 'x') {
+    d->error = d->offset - 1;
+    return false;
+  }
+  if (hexIsDigit(c)) {
+    d->stage[d->len++] = (char)c;
+    d->run++;
+  } else if ((c | 0x20) == 'x') {
+    if (d->backslash) {
+      d->backslash = false;
+    } else if (d->run == 1 && d->stage[d->len - 1] == '0') {
+      d->len--; /* that '0' was a prefix */
+      d->run = 0;
+    } else {
+      d->error = d->offset;
+      return false;
+    }
+  } else if (c == '\\' || hexIsSep(c)) {
+    if (!hexDecEndRun(d))
+      return false;
+    d->backslash = (c == '\\');
+  } else {
+    d->error = d->offset;
+    return false;
+  }
+  d->offset++;
+  return true;
+}
+
+#ifdef ASCIIHEXER_SIMD
+/* one block of 16 chars, false if it needs the state machine */
+__attribute__((target("ssse3")))
+static bool hexDecBlockSsse3(struct hexDec *d, const uint8_t *in) {
+  __m128i c = _mm_loadu_si128((const __m128i *)in);
+  __m128i lc = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  __m128i num = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lc, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lc, _mm_set1_epi8('f' + 1)));
+  __m128i sep = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8(','))),
+                             _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('"')),
+                                          _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('\t' - 1)),
+                                                        _mm_cmplt_epi8(c, _mm_set1_epi8('\r' + 1)))));
+  uint32_t D = (uint32_t)_mm_movemask_epi8(_mm_or_si128(num, alpha));
+  uint32_t Z = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('0')));
+  uint32_t X = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lc, _mm_set1_epi8('x')));
+  uint32_t B = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+  uint32_t S = (uint32_t)_mm_movemask_epi8(sep);
+  uint32_t Dprev, K, m, shift;
+  int run = d->run;
+
+  if (D == 0xFFFF && !d->backslash) {
+    _mm_storeu_si128((__m128i *)&d->stage[d->len], c);
+    d->len += 16;
+    d->run += 16;
+    d->offset += 16;
+    return true;
+  }
+  if ((D | X | B | S) != 0xFFFF || d->backslash || (X & 1) || (B & 0x8000) || ((B << 1) & ~X))
+    return false;
+  /* an 'x' follows a '\' or a '0' that is a run of its own */
+  Dprev = (D << 1) | (run > 0);
+  if ((X >> 1) & ~(B | (Z & ~Dprev)))
+    return false;
+  K = D & ~(Z & (X >> 1));
+
+  /* all runs that end in this block must be even */
+  if (run > 0 && !(K & 1) && (run & 1))
+    return false;
+  for (m = K, shift = 0; m != 0; ) {
+    int start = __builtin_ctz(m), len = __builtin_ctz(~(m >> start));
+    int total = len + ((start == 0 && shift == 0) ? run : 0);
+
+    if (start + len < 16 && (total & 1))
+      return false;
+    run = (start + len == 16) ? total : 0;
+    m &= ~(((1u << len) - 1u) << start);
+    shift = 1;
+  }
+  if (!(K & 0x8000))
+    run = 0;
+
+  /* compact the kept digits into the stage, 8 chars at a time */
+  _mm_storel_epi64((__m128i *)&d->stage[d->len],
+                   _mm_shuffle_epi8(c, _mm_loadl_epi64((const __m128i *)hexCompactLut[K & 0xFF])));
+  d->len += __builtin_popcount(K & 0xFF);
+  _mm_storel_epi64((__m128i *)&d->stage[d->len],
+                   _mm_shuffle_epi8(_mm_srli_si128(c, 8), _mm_loadl_epi64((const __m128i *)hexCompactLut[K >> 8])));
+  d->len += __builtin_popcount(K >> 8);
+  d->run = run;
+  d->offset += 16;
+  return true;
+}
+#endif
+
+static bool hexDecFeed(void *ctx, const uint8_t *in, size_t n) {
+  struct hexDec *d = ctx;
+  size_t pos = 0;
+
+  while (pos < n) {
+    if (d->len >= HEX_STAGE - 16)
+      hexDecFlush(d);
+#ifdef ASCIIHEXER_SIMD
+    if (useSsse3 && n - pos >= 16 && hexDecBlockSsse3(d, in + pos)) {
+      pos += 16;
+      continue;
+    }
+#endif
+    if (!hexDecChar(d, in[pos++]))
+      return false;
+  }
+  return true;
+}
+
+static bool hexDecFinish(struct hexDec *d) {
+  if (d->error < 0 && d->backslash)
+    d->error = d->offset - 1;
+  if (d->error < 0)
+    hexDecEndRun(d);
+  hexDecFlush(d);
+  sinkFlush(d->out);
+  return d->error < 0;
+}
+
+/* Dump mode, like xxd: "00000010: 4142 4344 4546 4748 494a 4b4c 4d4e 4f50  ABCDEFGHIJKLMNOP".
+ * The offsets of a mapped file are padded to the digits of the last one, so every full line has
+ * the same length and the output offset of any input chunk is known up front: a pool of workers
+ * formats DUMP_CHUNK byte chunks and pwrites them in place. Pipes, and output that cannot be
+ * written at an offset, are dumped sequentially.
+ */
+#define DUMP_COLS 16
+#define DUMP_HEX_LEN 41 /* 8 groups of 4 digits, separated and followed by spaces */
+#define DUMP_LINE_MAX (16 + 2 + DUMP_HEX_LEN + DUMP_COLS + 1)
+#define DUMP_CHUNK (1 << 18)
+
+struct hexDump {
+  struct hexTmpl tmpl;       /* hex columns of a full line */
+  int digits;                /* minimum offset digits */
+  size_t lineLen;            /* of a full line with that many digits */
+  /* parallel: the whole input, written at base */
+  const uint8_t *in;
+  uint64_t size;
+  off_t base;
+  uint64_t next;             /* next chunk to claim */
+  /* sequential */
+  struct hexSink *out;
+  uint64_t offset;
+  uint8_t carry[DUMP_COLS];  /* a started line */
+  size_t carryLen;
+};
+
+static void dumpTmpl(struct hexTmpl *t) {
+  int j;
+
+  for (j = 0; j < DUMP_COLS; j++) {
+    tmplByte(t, j);
+    if ((j & 1) && j < DUMP_COLS - 1)
+      tmplLit(t, " ");
+  }
+  tmplLit(t, "  ");
+  t->digits = hexDigitsLower;
+}
+
+#ifdef ASCIIHEXER_SIMD
+__attribute__((target("ssse3")))
+static void dumpAsciiSsse3(const uint8_t *in, char *out) {
+  __m128i c = _mm_loadu_si128((const __m128i *)in);
+  /* signed compares: bytes >= 0x80 are below ' ' too */
+  __m128i bad = _mm_or_si128(_mm_cmplt_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8(0x7F)));
+
+  _mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_andnot_si128(bad, c), _mm_and_si128(bad, _mm_set1_epi8('.'))));
+}
+#endif
+
+/* one line of n <= DUMP_COLS bytes at offset, returns its length; writes up to 16 chars past
+ * the end of a short line */
+static size_t dumpLine(const struct hexDump *d, uint64_t offset, const uint8_t *in, size_t n, char *out) {
+  uint8_t pad[DUMP_COLS];
+  int digits = d->digits, k;
+  char *p;
+
+  while (digits < 16 && (offset >> (4 * digits)) != 0)
+    digits++;
+  for (k = digits - 1; k >= 0; k--, offset >>= 4)
+    out[k] = hexDigitsLower[offset & 0x0F];
+  out[digits] = ':';
+  out[digits + 1] = ' ';
+  p = out + digits + 2;
+
+  if (n < DUMP_COLS) {
+    memset(pad, 0, sizeof(pad));
+    memcpy(pad, in, n);
+    in = pad;
   }
+  tmplApply(&d->tmpl, in, p);
+  for (k = n; k < DUMP_COLS; k++)
+    p[k * 2 + k / 2] = p[k * 2 + k / 2 + 1] = ' ';
+  p += DUMP_HEX_LEN;
+#ifdef ASCIIHEXER_SIMD
+  if (useSsse3 && n == DUMP_COLS)
+    dumpAsciiSsse3(in, p);
+  else
+#endif
+  for (k = 0; k < (int)n; k++)
+    p[k] = (in[k] >= ' ' && in[k] < 0x7F) ? (char)in[k] : '.';
+  p[n] = '\n';
+  return (p + n + 1) - out;
+}
+
+static void *dumpWorker(void *arg) {
+  struct hexDump *d = arg;
+  char *buf = malloc((DUMP_CHUNK / DUMP_COLS) * DUMP_LINE_MAX + 16);
+  uint64_t chunk;
+
+  if (buf == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  while ((chunk = __atomic_fetch_add(&d->next, 1, __ATOMIC_RELAXED)) < (d->size + DUMP_CHUNK - 1) / DUMP_CHUNK) {
+    uint64_t pos = chunk * DUMP_CHUNK, end = (d->size - pos > DUMP_CHUNK ? pos + DUMP_CHUNK : d->size);
+    off_t at = d->base + (off_t)(pos / DUMP_COLS * d->lineLen);
+    size_t len = 0, done = 0;
+
+    for (; pos < end; pos += DUMP_COLS)
+      len += dumpLine(d, pos, d->in + pos, (end - pos < DUMP_COLS ? end - pos : DUMP_COLS), buf + len);
+    while (done < len) {
+      ssize_t n = pwrite(STDOUT_FILENO, buf + done, len - done, at + done);
+
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0) {
+        perror("pwrite");
+        exit(1);
+      }
+      done += n;
+    }
+  }
+  free(buf);
+  return NULL;
+}
+
+/* dump a mapped file with threads workers (0: one per online cpu) if stdout is a regular
+ * file, false if the sequential dump has to do it */
+static bool dumpParallel(struct hexDump *d, int fd, unsigned int threads) {
+  uint64_t chunks, last, total;
+  struct stat st, ost;
+  unsigned int t;
+  int flags = fcntl(STDOUT_FILENO, F_GETFL);
+  uint8_t *map;
+
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    return false;
+  /* pwrite ignores the offset with O_APPEND */
+  if (flags < 0 || (flags & O_APPEND) || fstat(STDOUT_FILENO, &ost) != 0 || !S_ISREG(ost.st_mode))
+    return false;
+  d->base = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+  if (d->base < 0)
+    return false;
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  d->in = map;
+  d->size = st.st_size;
+  last = (d->size - 1) & ~(uint64_t)(DUMP_COLS - 1);
+  while (d->digits < 16 && (last >> (4 * d->digits)) != 0)
+    d->digits++;
+  d->lineLen = d->digits + 2 + DUMP_HEX_LEN + DUMP_COLS + 1;
+  total = last / DUMP_COLS * d->lineLen + d->lineLen - (DUMP_COLS - (d->size - last));
+  chunks = (d->size + DUMP_CHUNK - 1) / DUMP_CHUNK;
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    threads = (cpus > 0 ? (unsigned int)cpus : 1);
+  }
+  if (threads > chunks)
+    threads = (unsigned int)chunks;
+  {
+    pthread_t tids[threads];
+
+    for (t = 1; t < threads; t++) {
+      if (pthread_create(&tids[t], NULL, dumpWorker, d) != 0) {
+        perror("pthread_create");
+        exit(1);
+      }
+    }
+    dumpWorker(d);
+    for (t = 1; t < threads; t++)
+      pthread_join(tids[t], NULL);
+  }
+  munmap(map, d->size);
+  /* leave stdout behind the dump, as a sequential write would */
+  lseek(STDOUT_FILENO, d->base + (off_t)total, SEEK_SET);
+  return true;
+}
+
+static void dumpPut(struct hexDump *d, const uint8_t *in, size_t n) {
+  char *p = sinkReserve(d->out, DUMP_LINE_MAX);
+
+  d->out->len += dumpLine(d, d->offset, in, n, p);
+  d->offset += n;
+}
+
+static bool dumpFeed(void *ctx, const uint8_t *in, size_t n) {
+  struct hexDump *d = ctx;
+
+  while (n > 0) {
+    if (d->carryLen > 0 || n < DUMP_COLS) {
+      size_t k = (n < DUMP_COLS - d->carryLen ? n : DUMP_COLS - d->carryLen);
+
+      memcpy(d->carry + d->carryLen, in, k);
+      d->carryLen += k;
+      in += k;
+      n -= k;
+      if (d->carryLen == DUMP_COLS) {
+        dumpPut(d, d->carry, DUMP_COLS);
+        d->carryLen = 0;
+      }
+    } else {
+      dumpPut(d, in, DUMP_COLS);
+      in += DUMP_COLS;
+      n -= DUMP_COLS;
+    }
+  }
+  return true;
+}
+
+static void dumpFinish(struct hexDump *d) {
+  if (d->carryLen > 0)
+    dumpPut(d, d->carry, d->carryLen);
+  sinkFlush(d->out);
+}
+
+/* C source output: "static const unsigned char name[] = { 0x41, .. };" (or u16/u32/u64
+ * elements) and "\x41\x42" string literal lines, words with C separators */
+static void cSrcInit(struct hexWords *w, bool literal, int perLine) {
+  w->perLine = (perLine > 0 ? perLine : (literal ? 16 : 12));
+  w->sep = (literal ? "" : ", ");
+  w->lineSep = (literal ? "\"\n  \"" : ",\n  ");
+  w->prefix = (literal ? "\\x" : "0x");
+  w->digits = hexDigitsLower;
+  wordsInit(w);
+}
+
+static void cSrcBegin(struct hexWords *w, const char *name, bool literal) {
+  static const char *const types[9] = { NULL, "unsigned char", "uint16_t", NULL, "uint32_t",
+                                        NULL, NULL, NULL, "uint64_t" };
+  char *p;
+
+  if (name == NULL) {
+    sinkPut(w->out, "  \"", 3);
+    return;
+  }
+  p = sinkReserve(w->out, strlen(name) + 64);
+  if (literal)
+    w->out->len += sprintf(p, "static const unsigned char %s[] =\n  \"", name);
+  else
+    w->out->len += sprintf(p, "static const %s %s[] = {\n  ", types[w->width], name);
+}
+
+static void cSrcFinish(struct hexWords *w, const char *name, bool literal) {
+  char *p;
+
+  wordsTail(w);
+  if (literal)
+    sinkPut(w->out, (name != NULL ? "\";\n" : "\"\n"), (name != NULL ? 3 : 2));
+  else if (w->i == 0)
+    sinkPut(w->out, "0\n};\n", 5); /* C has no empty arrays: one element, NAME_len stays 0 */
+  else
+    sinkPut(w->out, "\n};\n", 4);
+  if (name != NULL) {
+    p = sinkReserve(w->out, strlen(name) + 64);
+    w->out->len += sprintf(p, "static const unsigned int %s_len = %llu;\n", name, (unsigned long long)w->i);
+  }
+  sinkFlush(w->out);
+}
+
+static void print_usage_and_exit(char *arg0) {
+  fprintf(stderr, "usage: %s [options] [TEXT]\n\n%s", arg0,
+    "where [options] can be:\n"
+    "\t-x\tbytes: 0x41 0x42 0x43\n"
+    "\t-w\tdwords: 0x41424344 0x45\n"
+    "\t-s\tstring: 0x4142434445\n"
+    "\t-g\twords: u16, u32 or u64, + le (default) or be; -g u16le: 0x4241 0x4443\n"
+    "\t-f\tread FILE instead of TEXT\n"
+    "\t-r\treverse: decode hex (0x41 0x42, \\x41\\x42, 4142, ..) to binary; not the output\n"
+    "\t\tof -s or -w for input with bytes below 0x10, it drops their leading zeros\n"
+    "\t-d\tdump: offset, hex and printable chars, 16 bytes per line (like xxd)\n"
+    "\t-t\tthreads for -d of a file to a file, 0 for one per cpu (default)\n"
+    "\t-c\tC array: static const unsigned char NAME[] = { 0x41, .. }; and NAME_len\n"
+    "\t-q\tC string literal lines: \"\\x41\\x42\", a char array NAME with -c\n"
+    "\t-e\telements of -c: u8 (default), u16, u32 or u64, + le (default) or be\n"
+    "\t-l\telements per line of -c and -q (default 12, 16 for -q)\n"
+    "\t-h\tthis help\n\n"
+    "the formats (-x, -w, -s, -g may be repeated) come from one pass over the input\n"
+    "without options -x, -w and -s are printed, without TEXT (or -f) stdin is read\n");
+  exit(1);
 }
 
 int main(int argc, char **argv)
 {
-  if (argc != 2) {
-    fprintf(stderr, "usage: %s [TEXT]\n", argv[0]);
-    return 1;
+  static struct hexFmt fmts[3 + HEX_WORD_FMTS];
+  static struct hexWords words[HEX_WORD_FMTS];
+  void (*const tmpls[3])(struct hexTmpl *) = { defaultHexOut, dwordHexOut, strHexOut };
+  void (*const byteOuts[3])(struct hexSink *, uint8_t, uint64_t) = { defaultByteOut, dwordByteOut, strByteOut };
+  bool want[3] = { false, false, false }, reverse = false, dump = false, literal = false;
+  const char *name = NULL;
+  unsigned int threads = 0;
+  int width = 1, perLine = 0, wordFmts = 0;
+  bool big = false;
+  const char *path = NULL;
+  uint64_t i = 0;
+  int opt, f, fd = -1, count = 0;
+
+  while ((opt = getopt(argc, argv, "xwsg:f:rdt:c:qe:l:h")) != -1) {
+    switch (opt) {
+      case 'x': want[0] = true; break;
+      case 'w': want[1] = true; break;
+      case 's': want[2] = true; break;
+      case 'g':
+        if (wordFmts == HEX_WORD_FMTS || !wordsParse(optarg, &words[wordFmts].width, &words[wordFmts].big) ||
+            words[wordFmts].width == 1)
+          print_usage_and_exit(argv[0]);
+        wordFmts++;
+        break;
+      case 'f': path = optarg; break;
+      case 'r': reverse = true; break;
+      case 'd': dump = true; break;
+      case 't': threads = (unsigned int)strtoul(optarg, NULL, 10); break;
+      case 'c': name = optarg; break;
+      case 'q': literal = true; break;
+      case 'e':
+        if (!wordsParse(optarg, &width, &big))
+          print_usage_and_exit(argv[0]);
+        break;
+      case 'l': {
+        char *end;
+        long n = strtol(optarg, &end, 10);
+
+        if (end == optarg || *end != '\0' || n < 0 || n > WORDS_LINE_MAX)
+          print_usage_and_exit(argv[0]);
+        perLine = (int)n;
+        break;
+      }
+      default: print_usage_and_exit(argv[0]);
+    }
+  }
+  if (optind < argc - 1 || (path != NULL && optind != argc))
+    print_usage_and_exit(argv[0]);
+  if (literal && width != 1)
+    print_usage_and_exit(argv[0]);
+  if (path != NULL) {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+      perror(path);
+      return 1;
+    }
+  } else if (optind == argc) {
+    fd = STDIN_FILENO;
+  }
+  if (!want[0] && !want[1] && !want[2] && wordFmts == 0)
+    want[0] = want[1] = want[2] = true;
+
+#ifdef ASCIIHEXER_SIMD
+  useSsse3 = __builtin_cpu_supports("ssse3");
+#endif
+  hexCompactInit();
+  if (reverse) {
+    static struct hexSink out = { STDOUT_FILENO, NULL, 0, 0 };
+    static struct hexDec dec;
+
+    dec.out = &out;
+    dec.error = -1;
+    if (fd >= 0)
+      readInput(fd, hexDecFeed, &dec);
+    else
+      hexDecFeed(&dec, (const uint8_t *)argv[optind], strlen(argv[optind]));
+    if (!hexDecFinish(&dec)) {
+      fprintf(stderr, "%s: invalid hex at offset %lld\n", argv[0], (long long)dec.error);
+      return 1;
+    }
+    return 0;
+  }
+  if (dump) {
+    static struct hexSink out = { STDOUT_FILENO, NULL, 0, 0 };
+    static struct hexDump dmp;
+
+    dumpTmpl(&dmp.tmpl);
+    tmplDone(&dmp.tmpl);
+    dmp.digits = 8;
+    dmp.out = &out;
+    if (fd >= 0 && dumpParallel(&dmp, fd, threads))
+      return 0;
+    if (fd >= 0)
+      readInput(fd, dumpFeed, &dmp);
+    else
+      dumpFeed(&dmp, (const uint8_t *)argv[optind], strlen(argv[optind]));
+    dumpFinish(&dmp);
+    return 0;
   }
+  if (name != NULL || literal) {
+    static struct hexSink out = { STDOUT_FILENO, NULL, 0, 0 };
+    static struct hexWords csrc;
 
-  defaultHexOut(argv[1]);
-  dwordHexOut(argv[1]);
-  strHexOut(argv[1]);
+    csrc.width = width;
+    csrc.big = big;
+    csrc.out = &out;
+    cSrcInit(&csrc, literal, perLine);
+    cSrcBegin(&csrc, name, literal);
+    if (fd >= 0)
+      readInput(fd, hexWordsFeed, &csrc);
+    else
+      wordsFeed(&csrc, (const uint8_t *)argv[optind], strlen(argv[optind]));
+    cSrcFinish(&csrc, name, literal);
+    return 0;
+  }
+  for (f = 0; f < 3 + wordFmts; f++) {
+    if (f < 3 && !want[f])
+      continue;
+    if (f < 3) {
+      tmpls[f](&fmts[count].tmpl);
+      tmplDone(&fmts[count].tmpl);
+      fmts[count].byteOut = byteOuts[f];
+    } else {
+      struct hexWords *w = &words[f - 3];
+
+      w->sep = " ";
+      w->prefix = "0x";
+      w->digits = hexDigits;
+      w->out = &fmts[count].sink;
+      wordsInit(w);
+      fmts[count].words = w;
+    }
+    /* the first format goes straight out, the others follow it: from memory for TEXT, else
+     * spooled to a temporary file, memory use must not depend on the input size */
+    fmts[count].sink.fd = (count == 0 ? STDOUT_FILENO : -1);
+    if (count > 0 && fd >= 0) {
+      char spool[] = "/tmp/asciihexer.XXXXXX";
+
+      /* an unlinked file: only the fd is kept, and the file goes away with it */
+      fmts[count].sink.fd = mkstemp(spool);
+      if (fmts[count].sink.fd < 0) {
+        perror("mkstemp");
+        return 1;
+      }
+      unlink(spool);
+    }
+    count++;
+  }
+
+  if (fd >= 0) {
+    struct hexEnc enc = { fmts, count, 0 };
+
+    readInput(fd, hexEncFeed, &enc);
+    i = enc.i;
+  } else {
+    hexFeed(fmts, count, (const uint8_t *)argv[optind], strlen(argv[optind]), &i);
+  }
+  hexFinish(fmts, count, i);
   return 0;
 }
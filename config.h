@@ -17,6 +17,9 @@
 /* set the cursor symbol */
 #define CURSOR_CHAR '#'
 
+/* node cache of the hashlife engine in MB, collected when it is full */
+#define HASHLIFE_CACHE_MB 256
+
 
 /**************
  * DummyShell *
@@ -6,16 +6,26 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <ctype.h>
+#ifndef GOL_HEADLESS
 #include <curses.h>
+#endif
 #include <time.h>
+#include <pthread.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(GOL_NO_SIMD)
+#include <immintrin.h>
+#define GOL_SIMD 1
+#endif
 
 /* configuration */
 #include "config.h"
 
-#if defined(RANDOM_SPAWNS)
+#if defined(RANDOM_SPAWNS) && !defined(GOL_HEADLESS)
 static uint8_t rnd_spawns = 0xFF;
 #endif
 
@@ -33,8 +43,17 @@ struct pattern {
 };
 
 struct cursor {
-	uint8_t x;
-	uint8_t y;
+	int x; /* on the screen */
+	int y;
+};
+
+/* the part of the world on the screen: a screen cell shows 2^zoom x 2^zoom cells */
+struct view {
+	int x; /* cell at the top left */
+	int y;
+	int zoom;
+	int cols;
+	int rows;
 };
 
 uint8_t start[3][3] = {
@@ -78,175 +97,1646 @@ uint8_t ship[3][3] = {
 	{0, 1, 1}
 };
 
+/*
+ * The world is one row-major buffer. Every row is surrounded by a halo of dead cells (a row above
+ * the first and below the last, a column left and right of each row): wrap_world copies the
+ * opposite borders into it once per generation, so the torus needs no wrapping per cell. Rows
+ * start WORLD_ALIGN aligned, the left halo cell is the last byte of the padding in front.
+ */
+#define WORLD_ALIGN 64
+
+struct world {
+	int width;
+	int height;
+	size_t stride; /* bytes per row, padding and halo included */
+	uint8_t * buf;
+	uint8_t * cells; /* cell (0|0) */
+};
+
+#define CELL(w, x, y) ((w)->cells[(ptrdiff_t)(y) * (ptrdiff_t)(w)->stride + (x)])
+
 /* initialize world with zero (dead cells) */
-void clean_world(uint8_t ** world, uint8_t width, uint8_t height) {
-	int a;
-	for (a = 0; a < width; a++) {
-		memset(world[a], 0, height * sizeof(uint8_t));
-	}
+void clean_world(struct world * world) {
+	memset(world->buf, 0, (world->height + 2) * world->stride);
 }
 
 /* allocate memory for world */
-uint8_t ** create_world(uint8_t width, uint8_t height) {
-	uint8_t ** world = calloc(width, sizeof(uint8_t *));
-	int a;
-	for (a = 0; a < width; a++) {
-		world[a] = calloc(height, sizeof(uint8_t));
+struct world * create_world(int width, int height) {
+	struct world * world = calloc(1, sizeof(struct world));
+
+	if (world == NULL) return NULL;
+	world->width = width;
+	world->height = height;
+	world->stride = WORLD_ALIGN + ((width + 1 + WORLD_ALIGN - 1) / WORLD_ALIGN) * WORLD_ALIGN;
+	if (posix_memalign((void **) &world->buf, WORLD_ALIGN, (height + 2) * world->stride) != 0) {
+		free(world);
+		return NULL;
 	}
+	world->cells = world->buf + world->stride + WORLD_ALIGN;
 
-	clean_world(world, width, height);
+	clean_world(world);
 	return world;
 }
 
-void free_world(uint8_t ** world, uint8_t width, uint8_t height) {
-	int a;
-	for (a = 0; a < width; a++) {
-		free(world[a]);
+void free_world(struct world * world) {
+	free(world->buf);
+	free(world);
+}
+
+/* copy the opposite borders into the halo */
+void wrap_world(struct world * world) {
+	int y;
+
+	memcpy(&CELL(world, 0, -1), &CELL(world, 0, world->height - 1), world->width);
+	memcpy(&CELL(world, 0, world->height), &CELL(world, 0, 0), world->width);
+	for (y = -1; y <= world->height; y++) {
+		CELL(world, -1, y) = CELL(world, world->width - 1, y);
+		CELL(world, world->width, y) = CELL(world, 0, y);
+	}
+}
+
+/* calc alive cells */
+uint64_t calc_cell_count(struct world * world) {
+	uint64_t cell_count = 0;
+	int a, b;
+
+	for (b = 0; b < world->height; b++) {
+		for (a = 0; a < world->width; a++) {
+			cell_count += CELL(world, a, b);
+		}
+	}
+
+	return cell_count;
+}
+
+/*
+ * Worker pool for large worlds: the rows of a generation are cut into one band per thread.
+ * The workers live as long as gol and meet the stepping thread at a barrier twice per
+ * generation, once to start on their bands and once when all are done. Bands read the rows
+ * around them from the wrapped source generation, they only write their own rows.
+ */
+#define POOL_MIN_CELLS (1 << 18) /* smaller worlds are stepped by the caller alone */
+#define POOL_MIN_ROWS 8
+
+struct pool {
+	int threads;
+	pthread_t * tids;
+	pthread_barrier_t barrier;
+	void (*rows)(void * world, void * next_gen, int y0, int y1);
+	void * world;
+	void * next_gen;
+	int height;
+	int bands;
+	int quit;
+};
+
+static struct pool pool = { 1 };
+
+static void pool_band(int band) {
+	if (band < pool.bands) {
+		pool.rows(pool.world, pool.next_gen, (int) ((int64_t) pool.height * band / pool.bands),
+			(int) ((int64_t) pool.height * (band + 1) / pool.bands));
+	}
+}
+
+static void * pool_worker(void * arg) {
+	int band = (int) (intptr_t) arg;
+
+	for (;;) {
+		pthread_barrier_wait(&pool.barrier);
+		if (pool.quit) break;
+		pool_band(band);
+		pthread_barrier_wait(&pool.barrier);
+	}
+	return NULL;
+}
+
+/* threads: 0 for one per online cpu */
+void pool_start(int threads) {
+	int t;
+
+	if (threads <= 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = (cpus > 0) ? (int) cpus : 1;
+	}
+	pool.threads = threads;
+	if (threads == 1) return;
+	pool.tids = calloc(threads, sizeof(pthread_t));
+	pthread_barrier_init(&pool.barrier, NULL, threads);
+	for (t = 1; t < threads; t++) {
+		if (pthread_create(&pool.tids[t], NULL, pool_worker, (void *) (intptr_t) t) != 0) {
+			perror("pthread_create");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+void pool_stop(void) {
+	int t;
+
+	if (pool.threads == 1) return;
+	pool.quit = 1;
+	pthread_barrier_wait(&pool.barrier);
+	for (t = 1; t < pool.threads; t++) {
+		pthread_join(pool.tids[t], NULL);
+	}
+	pthread_barrier_destroy(&pool.barrier);
+	free(pool.tids);
+	pool.threads = 1;
+}
+
+/* rows(world, next_gen, y0, y1) for all rows, in bands if the world is large enough */
+void pool_run(void (*rows)(void *, void *, int, int), void * world, void * next_gen, int width, int height) {
+	if (pool.threads == 1 || (int64_t) width * height < POOL_MIN_CELLS || height < 2 * POOL_MIN_ROWS) {
+		rows(world, next_gen, 0, height);
+		return;
+	}
+	pool.rows = rows;
+	pool.world = world;
+	pool.next_gen = next_gen;
+	pool.height = height;
+	pool.bands = (height / POOL_MIN_ROWS < pool.threads) ? height / POOL_MIN_ROWS : pool.threads;
+	pthread_barrier_wait(&pool.barrier); /* go */
+	pool_band(0);
+	pthread_barrier_wait(&pool.barrier); /* all bands done */
+}
+
+/*
+ * Vector kernels step the leading cells of a row (32 or 64 per instruction for bytes, 4 or 8
+ * words for bits) and return how many they did, the scalar loops finish the row. They are
+ * picked at runtime by select_kernels.
+ */
+#ifdef GOL_SIMD
+__attribute__((target("avx2")))
+static int calc_next_row_avx2(const uint8_t * up, const uint8_t * mid, const uint8_t * down, uint8_t * next, int width) {
+	const __m256i two = _mm256_set1_epi8(2), three = _mm256_set1_epi8(3), one = _mm256_set1_epi8(1);
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i m = _mm256_loadu_si256((const __m256i *) &mid[x]);
+		__m256i n = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) &up[x-1]), _mm256_loadu_si256((const __m256i *) &up[x]));
+
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &up[x+1]));
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &mid[x-1]));
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &mid[x+1]));
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &down[x-1]));
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &down[x]));
+		n = _mm256_add_epi8(n, _mm256_loadu_si256((const __m256i *) &down[x+1]));
+		/* 3: born or kept, 2: unchanged */
+		_mm256_storeu_si256((__m256i *) &next[x], _mm256_blendv_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(n, three), one), m, _mm256_cmpeq_epi8(n, two)));
+	}
+	return x;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static int calc_next_row_avx512(const uint8_t * up, const uint8_t * mid, const uint8_t * down, uint8_t * next, int width) {
+	const __m512i two = _mm512_set1_epi8(2), three = _mm512_set1_epi8(3);
+	int x;
+
+	for (x = 0; x + 64 <= width; x += 64) {
+		__m512i m = _mm512_loadu_si512(&mid[x]);
+		__m512i n = _mm512_add_epi8(_mm512_loadu_si512(&up[x-1]), _mm512_loadu_si512(&up[x]));
+
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&up[x+1]));
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&mid[x-1]));
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&mid[x+1]));
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&down[x-1]));
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&down[x]));
+		n = _mm512_add_epi8(n, _mm512_loadu_si512(&down[x+1]));
+		_mm512_storeu_si512(&next[x], _mm512_mask_blend_epi8(_mm512_cmpeq_epi8_mask(n, two),
+			_mm512_maskz_set1_epi8(_mm512_cmpeq_epi8_mask(n, three), 1), m));
+	}
+	return x;
+}
+#endif
+
+static int (*calc_next_row_simd)(const uint8_t * up, const uint8_t * mid, const uint8_t * down, uint8_t * next, int width);
+
+/* rows y0 to y1 - 1 of the next generation, needs a wrapped world */
+void calc_next_rows(struct world * world, struct world * next_gen, int y0, int y1) {
+	int x, y;
+
+	for (y = y0; y < y1; y++) {
+		const uint8_t * up = &CELL(world, 0, y - 1);
+		const uint8_t * mid = &CELL(world, 0, y);
+		const uint8_t * down = &CELL(world, 0, y + 1);
+		uint8_t * next = &CELL(next_gen, 0, y);
+
+		x = calc_next_row_simd ? calc_next_row_simd(up, mid, down, next, world->width) : 0;
+		for (; x < world->width; x++) {
+			uint8_t neighbours = up[x-1] + up[x] + up[x+1] + mid[x-1] + mid[x+1] + down[x-1] + down[x] + down[x+1];
+
+			/* born with 3, kept alive with 2 or 3 */
+			next[x] = (neighbours == 3) | ((neighbours == 2) & mid[x]);
+		}
+	}
+}
+
+static void calc_next_rows_pool(void * world, void * next_gen, int y0, int y1) {
+	calc_next_rows(world, next_gen, y0, y1);
+}
+
+void calc_next_gen(struct world * world, struct world * next_gen) {
+	wrap_world(world);
+	pool_run(calc_next_rows_pool, world, next_gen, world->width, world->height);
+}
+
+/*
+ * Bit-packed world: 64 cells per word, cell x of a row is bit x % 64 of word x / 64. Each row
+ * has a halo word on both sides and there are halo rows above and below. The west neighbour of
+ * cell 0 is bit 63 of the left halo word, the east neighbour of the last cell is the bit after
+ * it: in the unused bits of the last word, or bit 0 of the right halo word.
+ */
+struct bit_world {
+	int width;
+	int height;
+	size_t words; /* per row, halo words included */
+	uint64_t * buf;
+	uint64_t * rows; /* first word of row 0 */
+};
+
+#define BIT_ROW(w, y) ((w)->rows + (ptrdiff_t)(y) * (ptrdiff_t)(w)->words)
+
+void clean_bit_world(struct bit_world * world) {
+	memset(world->buf, 0, (world->height + 2) * world->words * sizeof(uint64_t));
+}
+
+struct bit_world * create_bit_world(int width, int height) {
+	struct bit_world * world = calloc(1, sizeof(struct bit_world));
+
+	if (world == NULL) return NULL;
+	world->width = width;
+	world->height = height;
+	world->words = (width + 63) / 64 + 2;
+	if (posix_memalign((void **) &world->buf, WORLD_ALIGN, (height + 2) * world->words * sizeof(uint64_t)) != 0) {
+		free(world);
+		return NULL;
 	}
+	world->rows = world->buf + world->words + 1;
+
+	clean_bit_world(world);
+	return world;
+}
+
+void free_bit_world(struct bit_world * world) {
+	free(world->buf);
 	free(world);
 }
 
-/* insert pattern at (x|y) into world */
-void inhabit_world(struct pattern pattern, uint8_t x, uint8_t y, uint8_t ** world, uint8_t width, uint8_t height) {
-	uint8_t a, b;
+static inline uint8_t bit_cell(const struct bit_world * world, int x, int y) {
+	return (BIT_ROW(world, y)[x / 64] >> (x % 64)) & 1;
+}
 
-	for (a = 0; a < pattern.height; a++) {
-		int c = a;
-		if ((y + c) >= height) c -= height;
+static inline void set_bit_cell(struct bit_world * world, int x, int y, uint8_t alive) {
+	uint64_t * word = &BIT_ROW(world, y)[x / 64];
 
-		for (b = 0; b < pattern.width; b++) {
-			int d = b;
-			if ((x + d) >= width) d -= width;
-			world[x+d][y+c] = pattern.data[(a*pattern.width)+b];
+	*word = (*word & ~(1ULL << (x % 64))) | ((uint64_t) (alive ? 1 : 0) << (x % 64));
+}
+
+/* the unused bits of the last word are dead, but for the one after the last cell */
+void wrap_bit_world(struct bit_world * world) {
+	size_t used = world->words - 2;
+	int y;
+
+	for (y = 0; y < world->height; y++) {
+		uint64_t * row = BIT_ROW(world, y);
+
+		row[-1] = (uint64_t) bit_cell(world, world->width - 1, y) << 63;
+		if (world->width % 64) {
+			row[used - 1] &= (1ULL << (world->width % 64)) - 1;
+			row[used - 1] |= (uint64_t) (row[0] & 1) << (world->width % 64);
+			row[used] = 0;
+		} else {
+			row[used] = row[0] & 1;
 		}
 	}
+	memcpy(BIT_ROW(world, -1) - 1, BIT_ROW(world, world->height - 1) - 1, world->words * sizeof(uint64_t));
+	memcpy(BIT_ROW(world, world->height) - 1, BIT_ROW(world, 0) - 1, world->words * sizeof(uint64_t));
 }
 
-/* calc alive cells */
-uint8_t calc_cell_count(uint8_t ** world, uint8_t width, uint8_t height) {
-	int cell_count = 0;
-	uint8_t a, b;
+uint64_t calc_bit_cell_count(struct bit_world * world) {
+	size_t used = world->words - 2, k;
+	uint64_t last = (world->width % 64) ? (1ULL << (world->width % 64)) - 1 : ~0ULL;
+	uint64_t cell_count = 0;
+	int y;
 
-	for (a = 0; a < width; a++) {
-		for (b = 0; b < height; b++) {
-			cell_count += (world[a][b]) ? 1 : 0;
+	for (y = 0; y < world->height; y++) {
+		const uint64_t * row = BIT_ROW(world, y);
+
+		for (k = 0; k + 1 < used; k++) {
+			cell_count += __builtin_popcountll(row[k]);
 		}
+		cell_count += __builtin_popcountll(row[used - 1] & last);
 	}
 
 	return cell_count;
 }
 
-uint8_t calc_cell_neighbours(uint8_t x, uint8_t y, uint8_t ** world, uint8_t width, uint8_t height) {
-	uint8_t neighbours = 0;
-	int a, b;
+/* next states of the 64 cells of mid[0], a full adder network over the eight neighbour bit
+ * planes: 2 bit sums of the rows above and below, the two neighbours in the row, then ones,
+ * twos and fours (or more) of the total */
+static inline uint64_t calc_next_bit_word(const uint64_t * up, const uint64_t * mid, const uint64_t * down) {
+	uint64_t aw = (up[0] << 1) | (up[-1] >> 63), ae = (up[0] >> 1) | (up[1] << 63);
+	uint64_t bw = (mid[0] << 1) | (mid[-1] >> 63), be = (mid[0] >> 1) | (mid[1] << 63);
+	uint64_t cw = (down[0] << 1) | (down[-1] >> 63), ce = (down[0] >> 1) | (down[1] << 63);
+	uint64_t sa = aw ^ up[0] ^ ae, ca = (aw & up[0]) | (ae & (aw ^ up[0]));
+	uint64_t sc = cw ^ down[0] ^ ce, cc = (cw & down[0]) | (ce & (cw ^ down[0]));
+	uint64_t sb = bw ^ be, cb = bw & be;
+	uint64_t ones = sa ^ sb ^ sc, c1 = (sa & sb) | (sc & (sa ^ sb));
+	uint64_t t = ca ^ cb ^ cc, c2 = (ca & cb) | (cc & (ca ^ cb));
+	uint64_t twos = t ^ c1, fours = c2 | (t & c1);
+
+	/* born with 3, kept alive with 2 or 3 */
+	return twos & ~fours & (ones | mid[0]);
+}
+
+#ifdef GOL_SIMD
+/* the same adder network on 4 words, the west and east neighbours come from loads shifted by a
+ * word */
+__attribute__((target("avx2")))
+static size_t calc_next_bit_row_avx2(const uint64_t * up, const uint64_t * mid, const uint64_t * down, uint64_t * next, size_t used) {
+	size_t k;
+
+	for (k = 0; k + 4 <= used; k += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) &up[k]);
+		__m256i b = _mm256_loadu_si256((const __m256i *) &mid[k]);
+		__m256i c = _mm256_loadu_si256((const __m256i *) &down[k]);
+		__m256i aw = _mm256_or_si256(_mm256_slli_epi64(a, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *) &up[k-1]), 63));
+		__m256i ae = _mm256_or_si256(_mm256_srli_epi64(a, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *) &up[k+1]), 63));
+		__m256i bw = _mm256_or_si256(_mm256_slli_epi64(b, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *) &mid[k-1]), 63));
+		__m256i be = _mm256_or_si256(_mm256_srli_epi64(b, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *) &mid[k+1]), 63));
+		__m256i cw = _mm256_or_si256(_mm256_slli_epi64(c, 1), _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *) &down[k-1]), 63));
+		__m256i ce = _mm256_or_si256(_mm256_srli_epi64(c, 1), _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *) &down[k+1]), 63));
+		__m256i sa = _mm256_xor_si256(_mm256_xor_si256(aw, a), ae);
+		__m256i ca = _mm256_or_si256(_mm256_and_si256(aw, a), _mm256_and_si256(ae, _mm256_xor_si256(aw, a)));
+		__m256i sc = _mm256_xor_si256(_mm256_xor_si256(cw, c), ce);
+		__m256i cc = _mm256_or_si256(_mm256_and_si256(cw, c), _mm256_and_si256(ce, _mm256_xor_si256(cw, c)));
+		__m256i sb = _mm256_xor_si256(bw, be), cb = _mm256_and_si256(bw, be);
+		__m256i ones = _mm256_xor_si256(_mm256_xor_si256(sa, sb), sc);
+		__m256i c1 = _mm256_or_si256(_mm256_and_si256(sa, sb), _mm256_and_si256(sc, _mm256_xor_si256(sa, sb)));
+		__m256i t = _mm256_xor_si256(_mm256_xor_si256(ca, cb), cc);
+		__m256i c2 = _mm256_or_si256(_mm256_and_si256(ca, cb), _mm256_and_si256(cc, _mm256_xor_si256(ca, cb)));
+		__m256i twos = _mm256_xor_si256(t, c1), fours = _mm256_or_si256(c2, _mm256_and_si256(t, c1));
+
+		_mm256_storeu_si256((__m256i *) &next[k], _mm256_andnot_si256(fours, _mm256_and_si256(twos, _mm256_or_si256(ones, b))));
+	}
+	return k;
+}
+
+/* 8 words, sums and carries are single ternary logic ops (0x96: xor, 0xE8: majority) */
+__attribute__((target("avx512f")))
+static size_t calc_next_bit_row_avx512(const uint64_t * up, const uint64_t * mid, const uint64_t * down, uint64_t * next, size_t used) {
+	size_t k;
+
+	for (k = 0; k + 8 <= used; k += 8) {
+		__m512i a = _mm512_loadu_si512(&up[k]);
+		__m512i b = _mm512_loadu_si512(&mid[k]);
+		__m512i c = _mm512_loadu_si512(&down[k]);
+		__m512i aw = _mm512_or_si512(_mm512_slli_epi64(a, 1), _mm512_srli_epi64(_mm512_loadu_si512(&up[k-1]), 63));
+		__m512i ae = _mm512_or_si512(_mm512_srli_epi64(a, 1), _mm512_slli_epi64(_mm512_loadu_si512(&up[k+1]), 63));
+		__m512i bw = _mm512_or_si512(_mm512_slli_epi64(b, 1), _mm512_srli_epi64(_mm512_loadu_si512(&mid[k-1]), 63));
+		__m512i be = _mm512_or_si512(_mm512_srli_epi64(b, 1), _mm512_slli_epi64(_mm512_loadu_si512(&mid[k+1]), 63));
+		__m512i cw = _mm512_or_si512(_mm512_slli_epi64(c, 1), _mm512_srli_epi64(_mm512_loadu_si512(&down[k-1]), 63));
+		__m512i ce = _mm512_or_si512(_mm512_srli_epi64(c, 1), _mm512_slli_epi64(_mm512_loadu_si512(&down[k+1]), 63));
+		__m512i sa = _mm512_ternarylogic_epi64(aw, a, ae, 0x96), ca = _mm512_ternarylogic_epi64(aw, a, ae, 0xE8);
+		__m512i sc = _mm512_ternarylogic_epi64(cw, c, ce, 0x96), cc = _mm512_ternarylogic_epi64(cw, c, ce, 0xE8);
+		__m512i sb = _mm512_xor_si512(bw, be), cb = _mm512_and_si512(bw, be);
+		__m512i ones = _mm512_ternarylogic_epi64(sa, sb, sc, 0x96), c1 = _mm512_ternarylogic_epi64(sa, sb, sc, 0xE8);
+		__m512i t = _mm512_ternarylogic_epi64(ca, cb, cc, 0x96), c2 = _mm512_ternarylogic_epi64(ca, cb, cc, 0xE8);
+		__m512i twos = _mm512_xor_si512(t, c1), fours = _mm512_or_si512(c2, _mm512_and_si512(t, c1));
+
+		_mm512_storeu_si512(&next[k], _mm512_andnot_si512(fours, _mm512_and_si512(twos, _mm512_or_si512(ones, b))));
+	}
+	return k;
+}
+#endif
+
+static size_t (*calc_next_bit_row_simd)(const uint64_t * up, const uint64_t * mid, const uint64_t * down, uint64_t * next, size_t used);
+
+/* rows y0 to y1 - 1 of the next generation, needs a wrapped world */
+void calc_next_bit_rows(struct bit_world * world, struct bit_world * next_gen, int y0, int y1) {
+	size_t used = world->words - 2, k;
+	int y;
+
+	for (y = y0; y < y1; y++) {
+		const uint64_t * up = BIT_ROW(world, y - 1);
+		const uint64_t * mid = BIT_ROW(world, y);
+		const uint64_t * down = BIT_ROW(world, y + 1);
+		uint64_t * next = BIT_ROW(next_gen, y);
+
+		k = calc_next_bit_row_simd ? calc_next_bit_row_simd(up, mid, down, next, used) : 0;
+		for (; k < used; k++) {
+			next[k] = calc_next_bit_word(up + k, mid + k, down + k);
+		}
+	}
+}
+
+static void calc_next_bit_rows_pool(void * world, void * next_gen, int y0, int y1) {
+	calc_next_bit_rows(world, next_gen, y0, y1);
+}
+
+void calc_next_bit_gen(struct bit_world * world, struct bit_world * next_gen) {
+	wrap_bit_world(world);
+	pool_run(calc_next_bit_rows_pool, world, next_gen, world->width, world->height);
+}
+
+/* the widest kernels the cpu has, up to limit ("scalar", "avx2" or "avx512", NULL for any);
+ * returns the name of the kernels in use */
+const char * select_kernels(const char * limit) {
+	calc_next_row_simd = NULL;
+	calc_next_bit_row_simd = NULL;
+#ifdef GOL_SIMD
+	__builtin_cpu_init();
+	if (limit != NULL && strcmp(limit, "scalar") == 0) return "scalar";
+	if ((limit == NULL || strcmp(limit, "avx512") == 0) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+		calc_next_row_simd = calc_next_row_avx512;
+		calc_next_bit_row_simd = calc_next_bit_row_avx512;
+		return "avx512";
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		calc_next_row_simd = calc_next_row_avx2;
+		calc_next_bit_row_simd = calc_next_bit_row_avx2;
+		return "avx2";
+	}
+#else
+	(void) limit;
+#endif
+	return "scalar";
+}
+
+/*
+ * Engines store and step the world; the rest of gol only talks to them through struct engine.
+ * byte, bit and tile wrap around at the borders, hashlife is an unbounded plane.
+ */
+struct engine {
+	const char * name;
+	int max_log2; /* largest step */
+	int unbounded; /* coordinates are not wrapped */
+	void * (*create)(int width, int height);
+	void (*destroy)(void * state);
+	void (*clean)(void * state);
+	uint8_t (*get)(void * state, int x, int y);
+	void (*set)(void * state, int x, int y, uint8_t alive);
+	void (*step)(void * state, int log2); /* 2^log2 generations */
+	uint64_t (*count)(void * state);
+	uint64_t (*block)(void * state, int x, int y, int log2); /* live cells of the 2^log2 square at (x|y) */
+	void (*fetch)(void * state, int x, int y, int cols, int rows, uint8_t * out); /* cells of the rectangle at (x|y), a byte each */
+};
+
+struct life {
+	const struct engine * engine;
+	void * state;
+	int width;
+	int height;
+};
+
+struct byte_life {
+	struct world * worlds[2];
+	int cur;
+};
+
+static void * byte_create(int width, int height) {
+	struct byte_life * l = calloc(1, sizeof(struct byte_life));
+
+	if (l == NULL) return NULL;
+	l->worlds[0] = create_world(width, height);
+	l->worlds[1] = create_world(width, height);
+	if (l->worlds[0] == NULL || l->worlds[1] == NULL) {
+		if (l->worlds[0] != NULL) free_world(l->worlds[0]);
+		if (l->worlds[1] != NULL) free_world(l->worlds[1]);
+		free(l);
+		return NULL;
+	}
+	return l;
+}
+
+static void byte_destroy(void * state) {
+	struct byte_life * l = state;
+
+	free_world(l->worlds[0]);
+	free_world(l->worlds[1]);
+	free(l);
+}
+
+static void byte_clean(void * state) {
+	struct byte_life * l = state;
+
+	clean_world(l->worlds[l->cur]);
+}
+
+static uint8_t byte_get(void * state, int x, int y) {
+	struct byte_life * l = state;
+
+	return CELL(l->worlds[l->cur], x, y);
+}
+
+static void byte_set(void * state, int x, int y, uint8_t alive) {
+	struct byte_life * l = state;
+
+	CELL(l->worlds[l->cur], x, y) = alive ? 1 : 0;
+}
+
+static void byte_step(void * state, int log2) {
+	struct byte_life * l = state;
+	uint64_t n;
+
+	for (n = 0; n < (1ULL << log2); n++) {
+		calc_next_gen(l->worlds[l->cur], l->worlds[!l->cur]);
+		l->cur = !l->cur;
+	}
+}
+
+static uint64_t byte_count(void * state) {
+	struct byte_life * l = state;
+
+	return calc_cell_count(l->worlds[l->cur]);
+}
+
+static uint64_t byte_block(void * state, int x, int y, int log2) {
+	struct byte_life * l = state;
+	const struct world * world = l->worlds[l->cur];
+	int size = 1 << log2, r, i;
+	uint64_t count = 0;
+
+	for (r = 0; r < size; r++) {
+		const uint8_t * row = &CELL(world, 0, (y + r) % world->height);
+		int a = x, n = size;
+
+		/* the square may be wider than the world */
+		while (n > 0) {
+			int len = (world->width - a < n) ? world->width - a : n;
+
+			for (i = a; i < a + len; i++) {
+				count += row[i];
+			}
+			n -= len;
+			a = 0;
+		}
+	}
+	return count;
+}
+
+static void byte_fetch(void * state, int x, int y, int cols, int rows, uint8_t * out) {
+	struct byte_life * l = state;
+	const struct world * world = l->worlds[l->cur];
+	int r, c;
+
+	for (r = 0; r < rows; r++) {
+		const uint8_t * row = &CELL(world, 0, (y + r) % world->height);
+		int a = x;
+
+		for (c = 0; c < cols; c++) {
+			*out++ = row[a];
+			if (++a == world->width) a = 0;
+		}
+	}
+}
+
+struct bit_life {
+	struct bit_world * worlds[2];
+	int cur;
+};
+
+static void * bit_create(int width, int height) {
+	struct bit_life * l = calloc(1, sizeof(struct bit_life));
+
+	if (l == NULL) return NULL;
+	l->worlds[0] = create_bit_world(width, height);
+	l->worlds[1] = create_bit_world(width, height);
+	if (l->worlds[0] == NULL || l->worlds[1] == NULL) {
+		if (l->worlds[0] != NULL) free_bit_world(l->worlds[0]);
+		if (l->worlds[1] != NULL) free_bit_world(l->worlds[1]);
+		free(l);
+		return NULL;
+	}
+	return l;
+}
+
+static void bit_destroy(void * state) {
+	struct bit_life * l = state;
+
+	free_bit_world(l->worlds[0]);
+	free_bit_world(l->worlds[1]);
+	free(l);
+}
+
+static void bit_clean(void * state) {
+	struct bit_life * l = state;
+
+	clean_bit_world(l->worlds[l->cur]);
+}
+
+static uint8_t bit_get(void * state, int x, int y) {
+	struct bit_life * l = state;
+
+	return bit_cell(l->worlds[l->cur], x, y);
+}
+
+static void bit_set(void * state, int x, int y, uint8_t alive) {
+	struct bit_life * l = state;
+
+	set_bit_cell(l->worlds[l->cur], x, y, alive);
+}
+
+static void bit_step(void * state, int log2) {
+	struct bit_life * l = state;
+	uint64_t n;
+
+	for (n = 0; n < (1ULL << log2); n++) {
+		calc_next_bit_gen(l->worlds[l->cur], l->worlds[!l->cur]);
+		l->cur = !l->cur;
+	}
+}
+
+static uint64_t bit_count(void * state) {
+	struct bit_life * l = state;
+
+	return calc_bit_cell_count(l->worlds[l->cur]);
+}
+
+/* live cells x0 to x1 - 1 of a row */
+static uint64_t bit_row_count(const uint64_t * row, int x0, int x1) {
+	uint64_t count = 0;
+	int k;
+
+	for (k = x0 / 64; k * 64 < x1; k++) {
+		uint64_t word = row[k];
+
+		if (k == x0 / 64) word &= ~0ULL << (x0 % 64);
+		if ((k + 1) * 64 > x1) word &= (1ULL << (x1 % 64)) - 1;
+		count += __builtin_popcountll(word);
+	}
+	return count;
+}
+
+static uint64_t bit_block(void * state, int x, int y, int log2) {
+	struct bit_life * l = state;
+	const struct bit_world * world = l->worlds[l->cur];
+	int size = 1 << log2, r;
+	uint64_t count = 0;
+
+	for (r = 0; r < size; r++) {
+		const uint64_t * row = BIT_ROW(world, (y + r) % world->height);
+		int a = x, n = size;
+
+		/* the square may be wider than the world */
+		while (n > 0) {
+			int len = (world->width - a < n) ? world->width - a : n;
+
+			count += bit_row_count(row, a, a + len);
+			n -= len;
+			a = 0;
+		}
+	}
+	return count;
+}
+
+static void bit_fetch(void * state, int x, int y, int cols, int rows, uint8_t * out) {
+	struct bit_life * l = state;
+	const struct bit_world * world = l->worlds[l->cur];
+	int r, c;
+
+	for (r = 0; r < rows; r++) {
+		const uint64_t * row = BIT_ROW(world, (y + r) % world->height);
+		int a = x;
+
+		for (c = 0; c < cols; c++) {
+			*out++ = (row[a / 64] >> (a % 64)) & 1;
+			if (++a == world->width) a = 0;
+		}
+	}
+}
+
+/*
+ * Tiles of 64x64 cells, a word per row, with activity tracking: a tile is only recomputed if
+ * it or one of its neighbours changed in the last generation, so a sparse world steps in time
+ * proportional to what moves. Tiles of the last column and row are partial if the world is
+ * not a multiple of 64; as in the bit world the bit after the last column holds the wrapped
+ * first cell. The population is kept up to date by every change.
+ */
+#define TILE 64
+
+struct tile {
+	uint64_t cells[TILE];
+	uint64_t next[TILE];
+	uint32_t population;
+	uint32_t stamp; /* activated in this generation */
+	uint8_t dirty; /* on the changed list */
+};
+
+struct tile_life {
+	int width;
+	int height;
+	int tw, th; /* tiles per row and column */
+	struct tile * tiles;
+	int * changed; /* tiles changed since the last step */
+	int nchanged;
+	int * active;
+	uint32_t stamp;
+	uint64_t population;
+};
+
+static inline uint8_t tile_cell(const struct tile_life * l, int x, int y) {
+	return (l->tiles[(y / TILE) * l->tw + x / TILE].cells[y % TILE] >> (x % TILE)) & 1;
+}
+
+static void tile_changed(struct tile_life * l, int t) {
+	if (!l->tiles[t].dirty) {
+		l->tiles[t].dirty = 1;
+		l->changed[l->nchanged++] = t;
+	}
+}
+
+static void * tile_create(int width, int height) {
+	struct tile_life * l = calloc(1, sizeof(struct tile_life));
+
+	if (l == NULL) return NULL;
+	l->width = width;
+	l->height = height;
+	l->tw = (width + TILE - 1) / TILE;
+	l->th = (height + TILE - 1) / TILE;
+	l->tiles = calloc((size_t) l->tw * l->th, sizeof(struct tile));
+	l->changed = calloc((size_t) l->tw * l->th, sizeof(int));
+	l->active = calloc((size_t) l->tw * l->th, sizeof(int));
+	if (l->tiles == NULL || l->changed == NULL || l->active == NULL) {
+		free(l->tiles);
+		free(l->changed);
+		free(l->active);
+		free(l);
+		return NULL;
+	}
+	return l;
+}
+
+static void tile_destroy(void * state) {
+	struct tile_life * l = state;
+
+	free(l->tiles);
+	free(l->changed);
+	free(l->active);
+	free(l);
+}
+
+static void tile_clean(void * state) {
+	struct tile_life * l = state;
+
+	memset(l->tiles, 0, (size_t) l->tw * l->th * sizeof(struct tile));
+	l->nchanged = 0;
+	l->stamp = 0;
+	l->population = 0;
+}
+
+static uint8_t tile_get(void * state, int x, int y) {
+	return tile_cell(state, x, y);
+}
+
+static void tile_set(void * state, int x, int y, uint8_t alive) {
+	struct tile_life * l = state;
+	int t = (y / TILE) * l->tw + x / TILE;
+	uint64_t * row = &l->tiles[t].cells[y % TILE], bit = 1ULL << (x % TILE);
+
+	if (((*row & bit) != 0) == (alive != 0)) return;
+	*row ^= bit;
+	l->tiles[t].population += alive ? 1 : -1;
+	l->population += alive ? 1 : -1;
+	tile_changed(l, t);
+}
+
+/* next generation of tile t into its next rows */
+static void tile_next(struct tile_life * l, int t) {
+	struct tile * tile = &l->tiles[t];
+	int tx = t % l->tw, x0 = tx * TILE, y0 = (t / l->tw) * TILE, r;
+	int cols = (l->width - x0 < TILE) ? l->width - x0 : TILE;
+	int rows = (l->height - y0 < TILE) ? l->height - y0 : TILE;
+	uint64_t mask = (cols < TILE) ? (1ULL << cols) - 1 : ~0ULL;
+	uint64_t w[TILE + 2][3]; /* west bit, the row, east bit */
+
+	for (r = -1; r <= rows; r++) {
+		int y = (y0 + r + l->height) % l->height;
+		uint64_t mid = l->tiles[(y / TILE) * l->tw + tx].cells[y % TILE];
+		uint64_t west = tile_cell(l, (x0 + l->width - 1) % l->width, y);
+		uint64_t east = tile_cell(l, (x0 + cols) % l->width, y);
+
+		if (cols < TILE) mid |= east << cols;
+		w[r + 1][0] = west << 63;
+		w[r + 1][1] = mid;
+		w[r + 1][2] = east;
+	}
+	for (r = 0; r < rows; r++) {
+		tile->next[r] = calc_next_bit_word(&w[r][1], &w[r + 1][1], &w[r + 2][1]) & mask;
+	}
+}
+
+static void tile_step_once(struct tile_life * l) {
+	int i, nactive = 0, dx, dy, r;
+
+	/* the changed tiles and their neighbours */
+	l->stamp++;
+	for (i = 0; i < l->nchanged; i++) {
+		int t = l->changed[i], tx = t % l->tw, ty = t / l->tw;
+
+		l->tiles[t].dirty = 0;
+		for (dy = -1; dy <= 1; dy++) {
+			for (dx = -1; dx <= 1; dx++) {
+				int n = ((ty + dy + l->th) % l->th) * l->tw + (tx + dx + l->tw) % l->tw;
+
+				if (l->tiles[n].stamp != l->stamp) {
+					l->tiles[n].stamp = l->stamp;
+					l->active[nactive++] = n;
+				}
+			}
+		}
+	}
+	for (i = 0; i < nactive; i++) {
+		tile_next(l, l->active[i]);
+	}
+
+	/* commit, the tiles that changed are the next ones to look at */
+	l->nchanged = 0;
+	for (i = 0; i < nactive; i++) {
+		struct tile * tile = &l->tiles[l->active[i]];
+		uint32_t population = 0;
+
+		if (memcmp(tile->cells, tile->next, sizeof(tile->cells)) == 0) continue;
+		memcpy(tile->cells, tile->next, sizeof(tile->cells));
+		for (r = 0; r < TILE; r++) {
+			population += __builtin_popcountll(tile->cells[r]);
+		}
+		l->population += (int64_t) population - tile->population;
+		tile->population = population;
+		tile_changed(l, l->active[i]);
+	}
+}
+
+static void tile_step(void * state, int log2) {
+	uint64_t n;
+
+	for (n = 0; n < (1ULL << log2); n++) {
+		tile_step_once(state);
+	}
+}
+
+static uint64_t tile_count(void * state) {
+	struct tile_life * l = state;
+
+	return l->population;
+}
+
+/* live cells x0 to x1 - 1 of row y */
+static uint64_t tile_row_count(const struct tile_life * l, int y, int x0, int x1) {
+	const struct tile * tiles = &l->tiles[(y / TILE) * l->tw];
+	uint64_t count = 0;
+	int k;
+
+	for (k = x0 / TILE; k * TILE < x1; k++) {
+		uint64_t word = tiles[k].cells[y % TILE];
+
+		if (k == x0 / TILE) word &= ~0ULL << (x0 % TILE);
+		if ((k + 1) * TILE > x1) word &= (1ULL << (x1 % TILE)) - 1;
+		count += __builtin_popcountll(word);
+	}
+	return count;
+}
+
+static uint64_t tile_block(void * state, int x, int y, int log2) {
+	struct tile_life * l = state;
+	int size = 1 << log2, r;
+	uint64_t count = 0;
+
+	for (r = 0; r < size; r++) {
+		int row = (y + r) % l->height, a = x, n = size;
 
-	for (a = x-1; a <= x+1; a++) {
-		int c = a;
-		if (a < 0) c += width;
-		if (a >= width) c -= width;
+		/* the square may be wider than the world */
+		while (n > 0) {
+			int len = (l->width - a < n) ? l->width - a : n;
 
-		for (b = y-1; b <= y+1; b++) {
-			int d = b;
-			if (a == x && b == y) continue;
-			if (b < 0) d += height;
-			if (b >= height) d -= height;
+			count += tile_row_count(l, row, a, a + len);
+			n -= len;
+			a = 0;
+		}
+	}
+	return count;
+}
+
+static void tile_fetch(void * state, int x, int y, int cols, int rows, uint8_t * out) {
+	struct tile_life * l = state;
+	int r, c;
 
-			neighbours += (world[c][d] > 0) ? 1 : 0;
+	for (r = 0; r < rows; r++) {
+		int a = x, row = (y + r) % l->height;
+
+		for (c = 0; c < cols; c++) {
+			*out++ = tile_cell(l, a, row);
+			if (++a == l->width) a = 0;
 		}
 	}
+}
+
+/*
+ * HashLife: the plane is a quadtree of canonical nodes, equal subtrees are the same node (hash
+ * consing), so a node's future is computed once and memoized. A node of level n covers 2^n x 2^n
+ * cells, its result is its center 2^(n-1) x 2^(n-1) square 2^min(step, n-2) generations later
+ * (step is the same for all nodes until it is changed). The plane is unbounded: the root grows
+ * while the pattern gets close to its borders. Nodes live in blocks, the hash table is their
+ * index; when there are more than max_nodes the ones neither the root nor a result still in
+ * progress uses are collected, when cells are set, before a step and inside it.
+ */
+#define HL_BLOCK 4096
+
+struct hl_node {
+	struct hl_node * nw, * ne, * sw, * se; /* NULL for the two leaves (cells) */
+	struct hl_node * result;
+	struct hl_node * next; /* hash chain or free list */
+	uint64_t population;
+	uint64_t hash;
+	uint8_t level;
+	uint8_t mark;
+};
+
+/* the nodes a result in progress holds on to */
+struct hl_frame {
+	struct hl_node * n, * sub[9], * r[9], * q[4];
+};
+
+struct hl_block {
+	struct hl_block * next;
+	struct hl_node nodes[HL_BLOCK];
+};
+
+struct hashlife {
+	struct hl_node off, on; /* the leaves */
+	struct hl_node * root;
+	struct hl_node * empty[64]; /* empty node per level */
+	struct hl_node ** table;
+	size_t buckets;
+	size_t nodes;
+	size_t max_nodes;
+	size_t collect_at; /* max_nodes, or more when most of the nodes are in use */
+	struct hl_frame * frames[64]; /* the results in progress */
+	int depth;
+	struct hl_node * free_nodes;
+	struct hl_block * blocks;
+	int step; /* log2 of the generations the results are ahead */
+	uint8_t rule[1 << 16]; /* center 2x2 of a 4x4 square one generation later */
+};
+
+static size_t hl_cache_mb = HASHLIFE_CACHE_MB;
 
-	return neighbours; /* 0 <= neighbours <= 8 */
+static uint64_t hl_hash(const struct hl_node * nw, const struct hl_node * ne, const struct hl_node * sw, const struct hl_node * se) {
+	uint64_t h = (uintptr_t) nw;
+
+	h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) ne;
+	h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) sw;
+	h = h * 0x9E3779B97F4A7C15ULL + (uintptr_t) se;
+	return h ^ (h >> 29);
+}
+
+static void hl_rehash(struct hashlife * hl, size_t buckets) {
+	struct hl_node ** table = calloc(buckets, sizeof(struct hl_node *));
+	size_t i;
+
+	if (table == NULL) return; /* longer chains then */
+	for (i = 0; i < hl->buckets; i++) {
+		struct hl_node * node = hl->table[i], * next;
+
+		for (; node != NULL; node = next) {
+			next = node->next;
+			node->next = table[node->hash & (buckets - 1)];
+			table[node->hash & (buckets - 1)] = node;
+		}
+	}
+	free(hl->table);
+	hl->table = table;
+	hl->buckets = buckets;
 }
 
-uint8_t calc_next_cell_gen(uint8_t x, uint8_t y, uint8_t ** world, uint8_t width, uint8_t height) {
-	fflush(stdout);
-	uint8_t neighbours = calc_cell_neighbours(x, y, world, width, height);
-	uint8_t alive = world[x][y];
+/* the canonical node with these children */
+static struct hl_node * hl_join(struct hashlife * hl, struct hl_node * nw, struct hl_node * ne, struct hl_node * sw, struct hl_node * se) {
+	uint64_t hash = hl_hash(nw, ne, sw, se);
+	struct hl_node ** bucket = &hl->table[hash & (hl->buckets - 1)];
+	struct hl_node * node;
+
+	for (node = *bucket; node != NULL; node = node->next) {
+		if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se) return node;
+	}
+	if (hl->free_nodes == NULL) {
+		struct hl_block * block = malloc(sizeof(struct hl_block));
+		int i;
 
-	if (alive) {
-		if (neighbours > 3 || neighbours < 2) {
-			return 0; /* died by over-/underpopulation */
+		if (block == NULL) {
+#ifndef GOL_HEADLESS
+			endwin();
+#endif
+			fprintf(stderr, "hashlife: out of memory\n");
+			exit(EXIT_FAILURE);
 		}
-		else {
-			return 1; /* kept alive */
+		block->next = hl->blocks;
+		hl->blocks = block;
+		for (i = 0; i < HL_BLOCK; i++) {
+			block->nodes[i].next = hl->free_nodes;
+			hl->free_nodes = &block->nodes[i];
 		}
 	}
-	else if (neighbours == 3) {
-		return 1; /* born */
+	node = hl->free_nodes;
+	hl->free_nodes = node->next;
+	node->nw = nw;
+	node->ne = ne;
+	node->sw = sw;
+	node->se = se;
+	node->result = NULL;
+	node->population = nw->population + ne->population + sw->population + se->population;
+	node->hash = hash;
+	node->level = nw->level + 1;
+	node->mark = 0;
+	node->next = *bucket;
+	*bucket = node;
+	if (++hl->nodes > hl->buckets) hl_rehash(hl, hl->buckets * 2);
+	return node;
+}
+
+static struct hl_node * hl_empty(struct hashlife * hl, int level) {
+	if (hl->empty[level] == NULL) {
+		struct hl_node * e = (level == 0) ? &hl->off : hl_empty(hl, level - 1);
+
+		hl->empty[level] = (level == 0) ? e : hl_join(hl, e, e, e, e);
+	}
+	return hl->empty[level];
+}
+
+/* the centered node one level down */
+static struct hl_node * hl_center(struct hashlife * hl, struct hl_node * n) {
+	return hl_join(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+/* the centered node between w and e, and between n and s */
+static struct hl_node * hl_hcenter(struct hashlife * hl, struct hl_node * w, struct hl_node * e) {
+	return hl_join(hl, w->ne, e->nw, w->se, e->sw);
+}
+
+static struct hl_node * hl_vcenter(struct hashlife * hl, struct hl_node * n, struct hl_node * s) {
+	return hl_join(hl, n->sw, n->se, s->nw, s->ne);
+}
+
+/* a level 2 node as 16 bits, bit y * 4 + x */
+static unsigned int hl_bits(const struct hl_node * n) {
+	const struct hl_node * q[4] = {n->nw, n->ne, n->sw, n->se};
+	unsigned int bits = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		int x = (i & 1) * 2, y = (i >> 1) * 2;
+
+		bits |= (unsigned int) q[i]->nw->population << (y * 4 + x);
+		bits |= (unsigned int) q[i]->ne->population << (y * 4 + x + 1);
+		bits |= (unsigned int) q[i]->sw->population << ((y + 1) * 4 + x);
+		bits |= (unsigned int) q[i]->se->population << ((y + 1) * 4 + x + 1);
 	}
-	else {
-		return 0; /* still dead */
+	return bits;
+}
+
+static struct hl_node * hl_leaf(struct hashlife * hl, int alive) {
+	return alive ? &hl->on : &hl->off;
+}
+
+static void hl_collect(struct hashlife * hl, int keep_results);
+
+static struct hl_node * hl_result(struct hashlife * hl, struct hl_node * n) {
+	int i;
+
+	if (n->result != NULL) return n->result;
+	if (n->population == 0) {
+		n->result = hl_empty(hl, n->level - 1);
+	} else if (n->level == 2) {
+		uint8_t next = hl->rule[hl_bits(n)];
+
+		n->result = hl_join(hl, hl_leaf(hl, next & 1), hl_leaf(hl, next & 2), hl_leaf(hl, next & 4), hl_leaf(hl, next & 8));
+	} else {
+		struct hl_frame f = { 0 };
+
+		/* nine overlapping subnodes, advanced by half the step (or not at all when the step is
+		 * smaller than this level's), then four more results on top of them; the frame keeps
+		 * them through a collection in the nested results */
+		f.n = n;
+		hl->frames[hl->depth++] = &f;
+		if (hl->nodes > hl->collect_at) hl_collect(hl, 1);
+		f.sub[0] = n->nw;
+		f.sub[1] = hl_hcenter(hl, n->nw, n->ne);
+		f.sub[2] = n->ne;
+		f.sub[3] = hl_vcenter(hl, n->nw, n->sw);
+		f.sub[4] = hl_center(hl, n);
+		f.sub[5] = hl_vcenter(hl, n->ne, n->se);
+		f.sub[6] = n->sw;
+		f.sub[7] = hl_hcenter(hl, n->sw, n->se);
+		f.sub[8] = n->se;
+		for (i = 0; i < 9; i++) {
+			f.r[i] = (hl->step >= n->level - 2) ? hl_result(hl, f.sub[i]) : hl_center(hl, f.sub[i]);
+		}
+		f.q[0] = hl_result(hl, hl_join(hl, f.r[0], f.r[1], f.r[3], f.r[4]));
+		f.q[1] = hl_result(hl, hl_join(hl, f.r[1], f.r[2], f.r[4], f.r[5]));
+		f.q[2] = hl_result(hl, hl_join(hl, f.r[3], f.r[4], f.r[6], f.r[7]));
+		f.q[3] = hl_result(hl, hl_join(hl, f.r[4], f.r[5], f.r[7], f.r[8]));
+		n->result = hl_join(hl, f.q[0], f.q[1], f.q[2], f.q[3]);
+		hl->depth--;
 	}
+	return n->result;
+}
+
+/* one level up, the old root in the center */
+static struct hl_node * hl_expand(struct hashlife * hl, struct hl_node * n) {
+	struct hl_node * e = hl_empty(hl, n->level - 1);
+
+	return hl_join(hl, hl_join(hl, e, e, e, n->nw), hl_join(hl, e, e, n->ne, e),
+		hl_join(hl, e, n->sw, e, e), hl_join(hl, n->se, e, e, e));
 }
 
-void calc_next_gen(uint8_t ** world, uint8_t ** next_gen, uint8_t width, uint8_t height) {
-	uint8_t x, y;
+static void hl_mark(struct hl_node * n) {
+	if (n == NULL || n->mark) return;
+	n->mark = 1;
+	hl_mark(n->nw);
+	hl_mark(n->ne);
+	hl_mark(n->sw);
+	hl_mark(n->se);
+}
+
+/* drop all nodes neither the root nor a result in progress uses, and results pointing to them;
+ * all results if keep_results is 0 */
+static void hl_collect(struct hashlife * hl, int keep_results) {
+	size_t i;
+	int level, d;
+
+	hl_mark(hl->root);
+	for (level = 1; level < 64; level++) {
+		hl_mark(hl->empty[level]);
+	}
+	for (d = 0; d < hl->depth; d++) {
+		struct hl_frame * f = hl->frames[d];
+
+		hl_mark(f->n);
+		for (i = 0; i < 9; i++) {
+			hl_mark(f->sub[i]);
+			hl_mark(f->r[i]);
+		}
+		for (i = 0; i < 4; i++) {
+			hl_mark(f->q[i]);
+		}
+	}
+	for (i = 0; i < hl->buckets; i++) {
+		struct hl_node ** link = &hl->table[i], * node;
+
+		while ((node = *link) != NULL) {
+			if (!node->mark) {
+				*link = node->next;
+				node->next = hl->free_nodes;
+				hl->free_nodes = node;
+				hl->nodes--;
+				continue;
+			}
+			if (!keep_results || (node->result != NULL && !node->result->mark)) node->result = NULL;
+			link = &node->next;
+		}
+	}
+	for (i = 0; i < hl->buckets; i++) {
+		struct hl_node * node;
 
-	for (x = 0; x < width; x++) {
-		for (y = 0; y < height; y++) {
-			next_gen[x][y] = calc_next_cell_gen(x, y, world, width, height);
+		for (node = hl->table[i]; node != NULL; node = node->next) {
+			node->mark = 0;
 		}
 	}
+	/* not again before another half of the cache is used when most of it is still in use, and
+	 * never before another block of nodes, however small the cache */
+	hl->collect_at = hl->nodes + hl->max_nodes / 2;
+	if (hl->collect_at < hl->max_nodes) hl->collect_at = hl->max_nodes;
+	if (hl->collect_at < hl->nodes + HL_BLOCK) hl->collect_at = hl->nodes + HL_BLOCK;
+}
+
+/* root coordinates: the root covers -2^(level-1) to 2^(level-1) - 1 on both axes */
+static int hl_inside(const struct hashlife * hl, int64_t x, int64_t y) {
+	int64_t half = (int64_t) 1 << (hl->root->level - 1);
+
+	return x >= -half && x < half && y >= -half && y < half;
+}
+
+/* population of the node of the given level that holds (x|y) */
+static uint64_t hl_population(const struct hl_node * n, uint64_t x, uint64_t y, int level) {
+	while (n->level > level) {
+		uint64_t half = (uint64_t) 1 << (n->level - 1);
+
+		if (n->population == 0) return 0;
+		if (y < half) n = (x < half) ? n->nw : n->ne;
+		else n = (x < half) ? n->sw : n->se;
+		x &= half - 1;
+		y &= half - 1;
+	}
+	return n->population;
+}
+
+static struct hl_node * hl_set_cell(struct hashlife * hl, struct hl_node * n, uint64_t x, uint64_t y, uint8_t alive) {
+	uint64_t half;
+
+	if (n->level == 0) return hl_leaf(hl, alive);
+	half = (uint64_t) 1 << (n->level - 1);
+	if (y < half) {
+		if (x < half) return hl_join(hl, hl_set_cell(hl, n->nw, x, y, alive), n->ne, n->sw, n->se);
+		return hl_join(hl, n->nw, hl_set_cell(hl, n->ne, x - half, y, alive), n->sw, n->se);
+	}
+	if (x < half) return hl_join(hl, n->nw, n->ne, hl_set_cell(hl, n->sw, x, y - half, alive), n->se);
+	return hl_join(hl, n->nw, n->ne, n->sw, hl_set_cell(hl, n->se, x - half, y - half, alive));
+}
 
-	/* copy world */
-	for (x = 0; x < width; x++) {
-		for (y = 0; y < height; y++) {
-			world[x][y] = next_gen[x][y];
+static void * hl_create(int width, int height) {
+	struct hashlife * hl = calloc(1, sizeof(struct hashlife));
+	unsigned int bits, i;
+
+	(void) width;
+	(void) height;
+	if (hl == NULL) return NULL;
+	hl->on.population = 1;
+	hl->buckets = 1 << 16;
+	hl->table = calloc(hl->buckets, sizeof(struct hl_node *));
+	hl->max_nodes = (hl_cache_mb << 20) / (sizeof(struct hl_node) + sizeof(struct hl_node *));
+	hl->collect_at = hl->max_nodes;
+	for (bits = 0; bits < (1 << 16); bits++) {
+		for (i = 0; i < 4; i++) {
+			int x = 1 + (i & 1), y = 1 + (i >> 1), dx, dy, n = 0;
+
+			for (dy = -1; dy <= 1; dy++) {
+				for (dx = -1; dx <= 1; dx++) {
+					if (dx || dy) n += (bits >> ((y + dy) * 4 + x + dx)) & 1;
+				}
+			}
+			if (n == 3 || (n == 2 && ((bits >> (y * 4 + x)) & 1))) hl->rule[bits] |= 1 << i;
 		}
 	}
+	hl->root = hl_empty(hl, 3);
+	return hl;
+}
+
+static void hl_destroy(void * state) {
+	struct hashlife * hl = state;
+
+	while (hl->blocks != NULL) {
+		struct hl_block * next = hl->blocks->next;
+
+		free(hl->blocks);
+		hl->blocks = next;
+	}
+	free(hl->table);
+	free(hl);
+}
+
+static void hl_clean(void * state) {
+	struct hashlife * hl = state;
+
+	hl->root = hl_empty(hl, 3);
+}
+
+static uint8_t hl_get(void * state, int x, int y) {
+	struct hashlife * hl = state;
+	int64_t half = (int64_t) 1 << (hl->root->level - 1);
+
+	if (!hl_inside(hl, x, y)) return 0;
+	return (uint8_t) hl_population(hl->root, (uint64_t) (x + half), (uint64_t) (y + half), 0);
+}
+
+/* (x|y) is a multiple of 2^log2, the root grows until such squares are aligned in it */
+static uint64_t hl_block(void * state, int x, int y, int log2) {
+	struct hashlife * hl = state;
+	int64_t half;
+
+	while (hl->root->level <= log2) {
+		hl->root = hl_expand(hl, hl->root);
+	}
+	if (!hl_inside(hl, x, y)) return 0;
+	half = (int64_t) 1 << (hl->root->level - 1);
+	return hl_population(hl->root, (uint64_t) (x + half), (uint64_t) (y + half), log2);
+}
+
+/* the live cells of node n at (nx|ny) that are in the rectangle, skipping what is empty */
+static void hl_fetch_node(const struct hl_node * n, int64_t nx, int64_t ny, int64_t x, int64_t y, int cols, int rows, uint8_t * out) {
+	int64_t half;
+
+	if (n->population == 0) return;
+	if (n->level == 0) {
+		if (nx >= x && nx < x + cols && ny >= y && ny < y + rows) out[(ny - y) * cols + (nx - x)] = 1;
+		return;
+	}
+	half = (int64_t) 1 << (n->level - 1);
+	if (n->level < 62 && (nx >= x + cols || ny >= y + rows || nx + 2 * half <= x || ny + 2 * half <= y)) return;
+	hl_fetch_node(n->nw, nx, ny, x, y, cols, rows, out);
+	hl_fetch_node(n->ne, nx + half, ny, x, y, cols, rows, out);
+	hl_fetch_node(n->sw, nx, ny + half, x, y, cols, rows, out);
+	hl_fetch_node(n->se, nx + half, ny + half, x, y, cols, rows, out);
+}
+
+static void hl_fetch(void * state, int x, int y, int cols, int rows, uint8_t * out) {
+	struct hashlife * hl = state;
+	int64_t half = (int64_t) 1 << (hl->root->level - 1);
+
+	memset(out, 0, (size_t) cols * rows);
+	hl_fetch_node(hl->root, -half, -half, x, y, cols, rows, out);
+}
+
+static void hl_set(void * state, int x, int y, uint8_t alive) {
+	struct hashlife * hl = state;
+	int64_t half;
+
+	/* every cell set leaves a path of old nodes behind */
+	if (hl->nodes > hl->collect_at) hl_collect(hl, 1);
+	while (!hl_inside(hl, x, y)) {
+		hl->root = hl_expand(hl, hl->root);
+	}
+	half = (int64_t) 1 << (hl->root->level - 1);
+	hl->root = hl_set_cell(hl, hl->root, (uint64_t) (x + half), (uint64_t) (y + half), alive ? 1 : 0);
+}
+
+/* 2^log2 generations: grow the root until the pattern sits in its central 2^(level-2) square
+ * and the step fits, then the root's result is the new root */
+static void hl_step(void * state, int log2) {
+	struct hashlife * hl = state;
+	struct hl_node * r;
+
+	if (hl->nodes > hl->collect_at) hl_collect(hl, 1);
+	if (log2 != hl->step) {
+		hl_collect(hl, 0);
+		hl->step = log2;
+	}
+	for (;;) {
+		r = hl->root;
+		if (r->level >= log2 + 3 &&
+		    r->nw->se->se->population + r->ne->sw->sw->population +
+		    r->sw->ne->ne->population + r->se->nw->nw->population == r->population) break;
+		hl->root = hl_expand(hl, hl->root);
+	}
+	hl->root = hl_result(hl, hl->root);
+}
+
+static uint64_t hl_count(void * state) {
+	struct hashlife * hl = state;
+
+	return hl->root->population;
+}
+
+static const struct engine engines[] = {
+	{"bit", 10, 0, bit_create, bit_destroy, bit_clean, bit_get, bit_set, bit_step, bit_count, bit_block, bit_fetch},
+	{"byte", 10, 0, byte_create, byte_destroy, byte_clean, byte_get, byte_set, byte_step, byte_count, byte_block, byte_fetch},
+	{"tile", 10, 0, tile_create, tile_destroy, tile_clean, tile_get, tile_set, tile_step, tile_count, tile_block, tile_fetch},
+	{"hashlife", 60, 1, hl_create, hl_destroy, hl_clean, hl_get, hl_set, hl_step, hl_count, hl_block, hl_fetch}
+};
+
+const struct engine * find_engine(const char * name) {
+	size_t i;
+
+	for (i = 0; i < sizeof(engines)/sizeof(engines[0]); i++) {
+		if (strcmp(engines[i].name, name) == 0) return &engines[i];
+	}
+	return NULL;
+}
+
+int create_life(struct life * life, const struct engine * engine, int width, int height) {
+	life->engine = engine;
+	life->width = width;
+	life->height = height;
+	life->state = engine->create(width, height);
+	return (life->state != NULL) ? 0 : -1;
+}
+
+void free_life(struct life * life) {
+	life->engine->destroy(life->state);
+	life->state = NULL;
+}
+
+/* bounded worlds are tori, their coordinates are taken modulo the size */
+static inline void life_wrap(struct life * life, int * x, int * y) {
+	if (life->engine->unbounded) return;
+	*x = ((*x % life->width) + life->width) % life->width;
+	*y = ((*y % life->height) + life->height) % life->height;
+}
+
+static inline uint8_t life_cell(struct life * life, int x, int y) {
+	life_wrap(life, &x, &y);
+	return life->engine->get(life->state, x, y);
+}
+
+static inline void life_set(struct life * life, int x, int y, uint8_t alive) {
+	life_wrap(life, &x, &y);
+	life->engine->set(life->state, x, y, alive);
+}
+
+/* live cells of the 2^log2 square at (x|y) */
+uint64_t life_block(struct life * life, int x, int y, int log2) {
+	life_wrap(life, &x, &y);
+	return life->engine->block(life->state, x, y, log2);
+}
+
+/* cells of the rectangle at (x|y), a byte each */
+void life_fetch(struct life * life, int x, int y, int cols, int rows, uint8_t * out) {
+	life_wrap(life, &x, &y);
+	life->engine->fetch(life->state, x, y, cols, rows, out);
 }
 
-/* print world with colors and count of neighbours */
-void print_world(uint8_t ** world, uint8_t width, uint8_t height) {
-	uint8_t x, y;
-	move(0, 0); /* reset cursor */
+/* insert pattern at (x|y) into the world */
+void inhabit_life(struct pattern pattern, int x, int y, struct life * life) {
+	int a, b;
+
+	for (a = 0; a < pattern.height; a++) {
+		for (b = 0; b < pattern.width; b++) {
+			life_set(life, x + b, y + a, pattern.data[(a*pattern.width)+b]);
+		}
+	}
+}
+
+/* load a pattern in run length encoding centered at (x|y): "x = 3, y = 3" after the comments,
+ * then runs of b (dead) and o (alive), $ ends a row and ! the pattern; returns -1 if it can not
+ * be read */
+int load_pattern(const char * path, int x, int y, struct life * life) {
+	FILE * f = fopen(path, "r");
+	char line[256];
+	int width = 0, height = 0, a = 0, b = 0, run = 0, c;
+
+	if (f == NULL) return -1;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#') continue;
+		if (sscanf(line, " x = %d , y = %d", &width, &height) != 2) width = 0;
+		break;
+	}
+	if (width <= 0 || height <= 0) {
+		fclose(f);
+		return -1;
+	}
+
+	x -= width / 2;
+	y -= height / 2;
+	while ((c = fgetc(f)) != EOF && c != '!') {
+		if (isdigit(c)) {
+			run = run * 10 + (c - '0');
+			continue;
+		}
+		if (isspace(c)) continue;
+		if (run == 0) run = 1;
+		if (c == '$') {
+			b += run;
+			a = 0;
+		} else if (c == 'b' || c == '.') {
+			a += run;
+		} else {
+			for (; run > 0; run--) life_set(life, x + a++, y + b, 1);
+		}
+		run = 0;
+	}
+	fclose(f);
+	return 0;
+}
+
+/* the plane is not scrolled further, so that the screen stays in range of an int */
+#define VIEW_LIMIT (1 << 30)
+#define VIEW_MAX_ZOOM 16
+
+/* cell at the top left of a screen cell */
+static inline int view_x(const struct view * view, int sx) {
+	return view->x + (sx << view->zoom);
+}
+
+static inline int view_y(const struct view * view, int sy) {
+	return view->y + (sy << view->zoom);
+}
+
+/* zoomed out until a bounded world fits on the screen */
+int view_max_zoom(struct life * life, struct view * view) {
+	int zoom = 0;
+
+	if (life->engine->unbounded) return VIEW_MAX_ZOOM;
+	while (zoom < VIEW_MAX_ZOOM && ((view->cols << zoom) < life->width || (view->rows << zoom) < life->height)) zoom++;
+	return zoom;
+}
+
+void view_wrap(struct life * life, struct view * view) {
+	if (life->engine->unbounded) {
+		if (view->x < -VIEW_LIMIT) view->x = -VIEW_LIMIT;
+		if (view->x > VIEW_LIMIT) view->x = VIEW_LIMIT;
+		if (view->y < -VIEW_LIMIT) view->y = -VIEW_LIMIT;
+		if (view->y > VIEW_LIMIT) view->y = VIEW_LIMIT;
+	} else {
+		life_wrap(life, &view->x, &view->y);
+	}
+}
+
+/* scroll by screen cells */
+void view_move(struct life * life, struct view * view, int dx, int dy) {
+	view->x += dx * (1 << view->zoom);
+	view->y += dy * (1 << view->zoom);
+	view_wrap(life, view);
+}
+
+/* the cell under the cursor stays where it is, the top left is aligned to the new zoom */
+void view_zoom(struct life * life, struct view * view, struct cursor cur, int zoom) {
+	int x = view_x(view, cur.x), y = view_y(view, cur.y);
+
+	if (zoom < 0 || zoom > view_max_zoom(life, view)) return;
+	view->zoom = zoom;
+	view->x = (x - (cur.x << zoom)) & ~((1 << zoom) - 1);
+	view->y = (y - (cur.y << zoom)) & ~((1 << zoom) - 1);
+	view_wrap(life, view);
+}
+
+#ifndef GOL_HEADLESS
+/* what the screen shows: a cell is only drawn if its glyph or color changed since the last frame */
+struct frame {
+	int cols;
+	int rows;
+	uint8_t * cells; /* the view with a border of one cell, at zoom 0 */
+	chtype * shadow;
+};
+
+#define FRAME_STALE ((chtype) -1)
+
+/* everything is drawn again, e.g. after the menu covered it */
+void frame_invalidate(struct frame * frame) {
+	size_t i;
+
+	for (i = 0; i < (size_t) frame->cols * frame->rows; i++) {
+		frame->shadow[i] = FRAME_STALE;
+	}
+}
+
+int frame_resize(struct frame * frame, int cols, int rows) {
+	free(frame->cells);
+	free(frame->shadow);
+	frame->cols = cols;
+	frame->rows = rows;
+	frame->cells = malloc((size_t) (cols + 2) * (rows + 2));
+	frame->shadow = malloc((size_t) cols * rows * sizeof(chtype));
+	if (frame->cells == NULL || frame->shadow == NULL) return -1;
+	frame_invalidate(frame);
+	return 0;
+}
+
+void free_frame(struct frame * frame) {
+	free(frame->cells);
+	free(frame->shadow);
+}
+
+/* print world with colors and count of neighbours, zoomed out the eighths of live cells; the
+ * neighbours are counted in the fetched view, not in the world */
+void print_world(struct life * life, struct view * view, struct frame * frame) {
+	uint64_t area = 1ULL << (2 * view->zoom);
+	int x, y, w = frame->cols + 2;
+
+	if (view->zoom == 0) life_fetch(life, view_x(view, -1), view_y(view, -1), w, frame->rows + 2, frame->cells);
 
 	/* cells */
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			uint8_t neighbours = calc_cell_neighbours(x, y, world, width, height);
+	for (y = 0; y < frame->rows; y++) {
+		for (x = 0; x < frame->cols; x++) {
+			chtype * shown = &frame->shadow[y * frame->cols + x];
+			uint8_t shade, alive;
+			chtype ch;
+
+			if (view->zoom == 0) {
+				const uint8_t * c = &frame->cells[(y + 1) * w + x + 1];
+
+				shade = c[-w-1] + c[-w] + c[-w+1] + c[-1] + c[1] + c[w-1] + c[w] + c[w+1];
+				alive = c[0];
+			} else {
+				uint64_t count = life_block(life, view_x(view, x), view_y(view, y), view->zoom);
+
+				shade = (uint8_t) ((count * 8 + area - 1) / area);
+				alive = (count != 0);
+			}
 
-			if (neighbours > 1) attron(COLOR_PAIR(neighbours));
-			addch((world[x][y]) ? '0' + neighbours : ' ');
-			if (neighbours > 1) attroff(COLOR_PAIR(neighbours));
+			ch = (alive ? '0' + shade : ' ') | ((shade > 1) ? COLOR_PAIR(shade) : 0);
+			if (*shown != ch) {
+				mvaddch(y, x, ch);
+				*shown = ch;
+			}
 		}
 	}
 }
 
 #ifdef ENABLE_CURSOR
-void print_cursor(uint8_t ** world, struct cursor cur) {
-	uint8_t color = (world[cur.x][cur.y]) ? 7 : 6;
+void print_cursor(struct life * life, struct view * view, struct frame * frame, struct cursor cur) {
+	uint8_t color = (life_cell(life, view_x(view, cur.x), view_y(view, cur.y))) ? 7 : 6;
 
 	move(cur.y, cur.x);
 	addch(CURSOR_CHAR | A_BLINK | A_BOLD | A_STANDOUT | COLOR_PAIR(color));
+	frame->shadow[cur.y * frame->cols + cur.x] = FRAME_STALE; /* the cell under it, next frame */
 }
 #endif
 
 #ifdef ENABLE_HOTKEYS
 #define MENU_WIDTH 25
-void print_menu(uint8_t width, uint8_t height) {
-	uint8_t startx, starty, mwdth_rel, posy = 0;
+#define MENU_HEIGHT 19
+void print_menu(int cols, int rows) {
+	int startx, starty, i, j;
 
-	mwdth_rel = (uint8_t) (MENU_WIDTH)/2+10;
-	startx = (uint8_t) (width/2) - mwdth_rel;
-	starty = (uint8_t) (height/2) - (uint8_t) (mwdth_rel/2);
+	startx = cols/2 - MENU_WIDTH/2;
+	starty = rows/2 - MENU_HEIGHT/2;
 	attron(COLOR_PAIR(1));
-	for (int i = 0; i < MENU_WIDTH; i++) {
-		mvprintw(starty, startx+i, "-");
-		mvprintw(starty+(mwdth_rel*2/3), startx+i, "-");
-		if (i % 2 == 0) {
-			mvprintw(starty+posy+1, startx-1, "|");
-			mvprintw(starty+posy+1, startx+MENU_WIDTH, "|");
-			posy++;
-		}
-	}
-	mvprintw(starty, startx-1, "+");
-	mvprintw(starty, startx+MENU_WIDTH, "+");
-	mvprintw(starty+posy+1, startx-1, "+");
-	mvprintw(starty+posy+1, startx+MENU_WIDTH, "+");
-	for (int i = startx; i < startx+MENU_WIDTH; i++) {
-		for (int j = starty+1; j <= starty+posy; j++) {
-			mvprintw(j, i, " ");
+	for (j = 0; j < MENU_HEIGHT; j++) {
+		for (i = -1; i <= MENU_WIDTH; i++) {
+			char c = ' ';
+
+			if (j == 0 || j == MENU_HEIGHT-1) c = (i == -1 || i == MENU_WIDTH) ? '+' : '-';
+			else if (i == -1 || i == MENU_WIDTH) c = '|';
+			mvaddch(starty+j, startx+i, c);
 		}
 	}
 	mvprintw(starty+1, startx+1, "q   ~ Exit");
@@ -257,6 +1747,9 @@ void print_menu(uint8_t width, uint8_t height) {
 	mvprintw(starty+7, startx+1, "p   ~ Pause");
 	mvprintw(starty+9, startx+1, "+/- ~ Change Framerate");
 	mvprintw(starty+11, startx+1, "0-5 ~ Create Pattern");
+	mvprintw(starty+13, startx+1, "</> ~ 2^k Gens per Step");
+	mvprintw(starty+15, startx+1, "hjkl ~ Scroll View");
+	mvprintw(starty+17, startx+1, "i/o ~ Zoom In/Out");
 	attroff(COLOR_PAIR(1));
 }
 #endif
@@ -285,28 +1778,132 @@ WINDOW * init_screen() {
 
 	return win;
 }
+#endif
+
+#define BENCH_SIZE 1024
+#define BENCH_GENERATIONS 1000
+
+/*
+ * Benchmark: a seeded soup (every cell alive with probability 1/2) or a loaded pattern, stepped
+ * without a terminal. The hash covers the live cells of the width x height rectangle at (0|0), so
+ * the bounded engines agree on it; hashlife has no borders and ends up elsewhere.
+ */
+static double clock_seconds(void) {
+	struct timespec ts;
 
-uint8_t **init_world(WINDOW *win, uint8_t **worlds[2], uint8_t *width, uint8_t *height) {
-	getmaxyx(win, *height, *width);
-	for (int i = 0; i < 2; i++)
-		worlds[i] = create_world(*width, *height);
-	return (worlds[0]);
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-void free_all(uint8_t **worlds[2], uint8_t width, uint8_t height) {
-	free_world(worlds[0], width, height);
-	free_world(worlds[1], width, height);
+static uint64_t splitmix64(uint64_t * state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
 }
 
-// returns realloc'd && resized world
-uint8_t **resized(WINDOW *win, uint8_t **worlds[2], uint8_t *width, uint8_t *height) {
-	free_world(worlds[0], *width, *height);
-	free_world(worlds[1], *width, *height);
-	return (init_world(win, worlds, width, height));
+void soup_life(struct life * life, uint64_t seed) {
+	uint64_t bits = 0;
+	int x, y;
+
+	for (y = 0; y < life->height; y++) {
+		for (x = 0; x < life->width; x++) {
+			if (x % 64 == 0) bits = splitmix64(&seed);
+			if ((bits >> (x % 64)) & 1) life_set(life, x, y, 1);
+		}
+	}
 }
 
-int main(int argc, char * argv[]) {
-	WINDOW * win = init_screen();
+/* FNV-1a over the rows, 64 cells to a word */
+uint64_t hash_life(struct life * life) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int x, y, i;
+
+	for (y = 0; y < life->height; y++) {
+		for (x = 0; x < life->width; x += 64) {
+			uint64_t word = 0;
+
+			for (i = 0; i < 64 && x + i < life->width; i++) {
+				word |= (uint64_t) life_cell(life, x + i, y) << i;
+			}
+			for (i = 0; i < 8; i++) {
+				hash = (hash ^ ((word >> (i * 8)) & 0xff)) * 0x100000001b3ULL;
+			}
+		}
+	}
+	return hash;
+}
+
+int bench(const char * arg0, const struct engine * engine, const char * kernels, int width, int height, uint64_t generations, uint64_t seed, const char * pattern_path) {
+	struct life life;
+	uint64_t left = generations;
+	double start, seconds;
+	int k;
+
+	if (create_life(&life, engine, width, height) != 0) {
+		fprintf(stderr, "%s: out of memory\n", arg0);
+		return (EXIT_FAILURE);
+	}
+	if (pattern_path == NULL) {
+		soup_life(&life, seed);
+	} else if (load_pattern(pattern_path, width/2, height/2, &life) != 0) {
+		fprintf(stderr, "%s: can not read pattern %s\n", arg0, pattern_path);
+		free_life(&life);
+		return (EXIT_FAILURE);
+	}
+
+	/* the largest steps the engine takes */
+	start = clock_seconds();
+	for (k = engine->max_log2; k >= 0; k--) {
+		while (left >= (1ULL << k)) {
+			engine->step(life.state, k);
+			left -= 1ULL << k;
+		}
+	}
+	seconds = clock_seconds() - start;
+
+	printf("{\n  \"tool\": \"gol\",\n  \"engine\": \"%s\",\n  \"kernels\": \"%s\",\n  \"threads\": %d,\n", engine->name, kernels, pool.threads);
+	printf("  \"width\": %d,\n  \"height\": %d,\n  \"generations\": %llu,\n", width, height, (unsigned long long) generations);
+	if (pattern_path == NULL) printf("  \"seed\": %llu,\n", (unsigned long long) seed);
+	else printf("  \"pattern\": \"%s\",\n", pattern_path);
+	printf("  \"seconds\": %.3f,\n  \"gens_per_s\": %.1f,\n  \"cell_updates_per_s\": %.4g,\n", seconds, generations / seconds, (double) width * height * generations / seconds);
+	printf("  \"population\": %llu,\n  \"hash\": \"%016llx\"\n}\n", (unsigned long long) engine->count(life.state), (unsigned long long) hash_life(&life));
+
+	free_life(&life);
+	return (EXIT_SUCCESS);
+}
+
+void print_usage_and_exit(char *arg0) {
+	fprintf(stderr, "usage: %s [-e ENGINE] [-W WIDTH] [-H HEIGHT] [-k KERNEL] [-t THREADS] [-m MB] [-p PATTERN]\n"
+		"       %s -b [-g GENERATIONS] [-s SEED] [options]\n\n"
+		"\t-e\tbit (default, 64 cells per word), byte (a byte per cell), tile (steps only\n"
+		"\t\twhat changed) or hashlife (unbounded)\n"
+		"\t-W, -H\tsize of the world, the terminal by default (hashlife has no borders),\n"
+		"\t\t%d for -b\n"
+		"\t-p\tstart with the pattern in this RLE file\n"
+		"\t-b\tbenchmark: step without a terminal and print generations per second,\n"
+		"\t\tcell updates per second and a hash of the world as JSON\n"
+		"\t-g\tgenerations to benchmark (default %d)\n"
+		"\t-s\tseed of the random soup to benchmark, unless there is a pattern (default 1)\n"
+		"\t-k\twidest vector kernels to use: scalar, avx2 or avx512 (default)\n"
+		"\t-t\tthreads stepping large worlds, 0 for one per cpu (default)\n"
+		"\t-m\tnode cache of hashlife in MB (default %d)\n", arg0, arg0, BENCH_SIZE, BENCH_GENERATIONS, HASHLIFE_CACHE_MB);
+	exit(1);
+}
+
+#ifndef GOL_HEADLESS
+/* sleep until the next frame is due, a late frame is followed by the next one right away */
+static void frame_wait(double * due, int framerate) {
+	double now = clock_seconds();
+
+	*due += 1.0 / framerate;
+	if (*due > now) usleep((useconds_t) ((*due - now) * 1e6));
+	else *due = now;
+}
+
+int play(const char * arg0, const struct engine * engine, int world_width, int world_height, const char * pattern_path) {
+	WINDOW * win;
 #ifdef ENABLE_CURSOR
 	MEVENT event;
 #endif
@@ -317,33 +1914,57 @@ int main(int argc, char * argv[]) {
 		{3, 3, (uint8_t *) glider},
 		{5, 4, (uint8_t *) segler},
 		{3, 7, (uint8_t *) buffer},
-		{8, 4, (uint8_t *) kreuz},
-		{6, 6, (uint8_t *) ship}
+		{3, 3, (uint8_t *) kreuz},
+		{3, 3, (uint8_t *) ship}
 	};
 	struct cursor cur = {0, 0};
+	struct view view = {0, 0, 0, 0, 0};
+	struct frame frame = {0, 0, NULL, NULL};
 	struct config cfg;
 
-	int generation = 0, input, framerate = 17;
-	uint8_t width, height;
-	uint8_t ** worlds[2], ** world;
+	uint64_t generation = 0;
+	double due;
+	int input, framerate = 17, step_log = 0;
+	struct life life;
 #if defined(RANDOM_SPAWNS)
 	int idle_gens = 0;
 	srand(time(NULL));
 #endif
 
+	win = init_screen();
+
 	memset(&cfg, '\0', sizeof(struct config));
-	/* initialize world */
-	world = init_world(win, worlds, &width, &height);
-	/* make the world real */
-	inhabit_world(patterns[3], width/2, height/2, worlds[0], width, height);
+	/* initialize world, as large as the screen unless told otherwise */
+	getmaxyx(win, view.rows, view.cols);
+	if (world_width == 0) world_width = view.cols;
+	if (world_height == 0) world_height = view.rows;
+	if (frame_resize(&frame, view.cols, view.rows) != 0 || create_life(&life, engine, world_width, world_height) != 0) {
+		free_frame(&frame);
+		endwin();
+		fprintf(stderr, "%s: out of memory\n", arg0);
+		return (EXIT_FAILURE);
+	}
+	/* make the world real, in the middle of the view */
+	view.x = engine->unbounded ? -view.cols/2 : world_width/2 - view.cols/2;
+	view.y = engine->unbounded ? -view.rows/2 : world_height/2 - view.rows/2;
+	view_wrap(&life, &view);
+	if (pattern_path == NULL) {
+		inhabit_life(patterns[3], view_x(&view, view.cols/2), view_y(&view, view.rows/2), &life);
+	} else if (load_pattern(pattern_path, view_x(&view, view.cols/2), view_y(&view, view.rows/2), &life) != 0) {
+		free_life(&life);
+		free_frame(&frame);
+		endwin();
+		fprintf(stderr, "%s: can not read pattern %s\n", arg0, pattern_path);
+		return (EXIT_FAILURE);
+	}
 
 	/* simulation loop */
+	due = clock_seconds();
 	while(!cfg.quit) {
 		if (!cfg.paused) {
 			/* calc next generation */
-			usleep(1 / (float) framerate * 1000000); /* sleep */
-			calc_next_gen(world, worlds[++generation % 2], width, height);
-			world = worlds[generation % 2]; /* new world */
+			life.engine->step(life.state, step_log);
+			generation += 1ULL << step_log;
 		}
 
 		/* handle events */
@@ -357,6 +1978,38 @@ int main(int argc, char * argv[]) {
 				if (framerate > 1) framerate--;
 				break;
 
+			case '>': /* twice the generations per step */
+				if (step_log < life.engine->max_log2) step_log++;
+				break;
+
+			case '<':
+				if (step_log > 0) step_log--;
+				break;
+
+			case 'h': /* scroll by a quarter of the screen */
+				view_move(&life, &view, -(view.cols/4 + 1), 0);
+				break;
+
+			case 'l':
+				view_move(&life, &view, view.cols/4 + 1, 0);
+				break;
+
+			case 'k':
+				view_move(&life, &view, 0, -(view.rows/4 + 1));
+				break;
+
+			case 'j':
+				view_move(&life, &view, 0, view.rows/4 + 1);
+				break;
+
+			case 'i': /* zoom in */
+				view_zoom(&life, &view, cur, view.zoom - 1);
+				break;
+
+			case 'o': /* zoom out */
+				view_zoom(&life, &view, cur, view.zoom + 1);
+				break;
+
 			case 'q': /* quit */
 				cfg.quit = 1;
 				break;
@@ -370,7 +2023,7 @@ int main(int argc, char * argv[]) {
 				break;
 
 			case 'c': /* clean world */
-				clean_world(world, width, height);
+				life.engine->clean(life.state);
 				generation = 0;
 				break;
 #endif
@@ -381,51 +2034,66 @@ int main(int argc, char * argv[]) {
 			case '3':
 			case '4':
 			case '5':
-				inhabit_world(patterns[input - '0'], cur.x, cur.y, world, width, height);
+				inhabit_life(patterns[input - '0'], view_x(&view, cur.x), view_y(&view, cur.y), &life);
 				break;
 #endif
 #ifdef ENABLE_CURSOR
 			case ' ': /* toggle cell at cursor position */
-				world[cur.x][cur.y] = (world[cur.x][cur.y]) ? 0 : 1;
+				life_set(&life, view_x(&view, cur.x), view_y(&view, cur.y), !life_cell(&life, view_x(&view, cur.x), view_y(&view, cur.y)));
 				break;
 
 			case KEY_MOUSE: /* move cursor to mouse posititon */
 				if (getmouse(&event) == OK && event.bstate & BUTTON1_PRESSED) {
 					cur.x = event.x;
 					cur.y = event.y;
-					if (cur.x >= width) cur.x = width - 1;
-					if (cur.y >= height) cur.y = height - 1;
-					world[cur.x][cur.y] = (world[cur.x][cur.y]) ? 0 : 1;
+					if (cur.x >= view.cols) cur.x = view.cols - 1;
+					if (cur.y >= view.rows) cur.y = view.rows - 1;
+					life_set(&life, view_x(&view, cur.x), view_y(&view, cur.y), !life_cell(&life, view_x(&view, cur.x), view_y(&view, cur.y)));
 				}
 				break;
 
-			case KEY_UP:
+			case KEY_UP: /* at the border the view scrolls */
 				if (cur.y > 0) {
 					cur.y--;
+				} else {
+					view_move(&life, &view, 0, -1);
 				}
 				break;
 
 			case KEY_DOWN:
-				if (cur.y < height-1) {
+				if (cur.y < view.rows-1) {
 					cur.y++;
+				} else {
+					view_move(&life, &view, 0, 1);
 				}
 				break;
 
 			case KEY_LEFT:
 				if (cur.x > 0) {
 					cur.x--;
+				} else {
+					view_move(&life, &view, -1, 0);
 				}
 				break;
 
 			case KEY_RIGHT:
-				if (cur.x < width-1) {
+				if (cur.x < view.cols-1) {
 					cur.x++;
+				} else {
+					view_move(&life, &view, 1, 0);
 				}
 				break;
-			case KEY_RESIZE:
-				world = resized(win, worlds, &width, &height);
-				break;
 #endif
+			case KEY_RESIZE: /* only the view changes */
+				getmaxyx(win, view.rows, view.cols);
+				if (cur.x >= view.cols) cur.x = view.cols - 1;
+				if (cur.y >= view.rows) cur.y = view.rows - 1;
+				if (frame_resize(&frame, view.cols, view.rows) != 0) {
+					cfg.quit = 1;
+					continue; /* nothing to draw */
+				}
+				clear();
+				break;
 		}
 
 #if defined(RANDOM_SPAWNS)
@@ -435,35 +2103,114 @@ int main(int argc, char * argv[]) {
 			if (idle_gens >= RANDOM_SPAWNS && !cfg.paused)
 			{
 				idle_gens = 0;
-				inhabit_world(patterns[rand() % (sizeof(patterns)/sizeof(patterns[0]))], rand() % (width - 1), rand() % (height - 1), world, width, height);
+				struct pattern pattern = patterns[rand() % (sizeof(patterns)/sizeof(patterns[0]))];
+
+				/* anywhere in a bounded world, on the plane where we look */
+				if (life.engine->unbounded) {
+					inhabit_life(pattern, view_x(&view, rand() % view.cols), view_y(&view, rand() % view.rows), &life);
+				} else {
+					inhabit_life(pattern, rand() % life.width, rand() % life.height, &life);
+				}
 			}
 		}
 #endif
 
 		/* update screen */
-		print_world(world, width, height);
+		print_world(&life, &view, &frame);
 #ifdef ENABLE_CURSOR
-		print_cursor(world, cur);
+		print_cursor(&life, &view, &frame, cur);
 #endif
 #ifdef ENABLE_STATUS
+		/* over the first row of the world, which is drawn when it changes and covered again */
+		char status[256], size[32] = "plane";
+
+		if (!life.engine->unbounded) snprintf(size, sizeof(size), "%dx%d", life.width, life.height);
+		snprintf(status, sizeof(status), "[generation:%4llu] [step:2^%d] [cells:%3llu] [fps:%2d] [world:%s] [zoom:2^%d] [cursor:%2d|%2d]", (unsigned long long) generation, step_log, (unsigned long long) life.engine->count(life.state), framerate, size, view.zoom, view_x(&view, cur.x), view_y(&view, cur.y));
 		attron(COLOR_PAIR(1));
-		for (int i = 0; i < width; i++) mvprintw(0, width - i, " ");
-		mvprintw(0, 0, "[generation:%4d] [cells:%3d] [fps:%2d] [width:%d] [height:%d] [cursor:%2d|%2d]", generation, calc_cell_count(world, width, height), framerate, width, height, cur.x, cur.y);
-		if (cfg   .paused) mvprintw(0, width-6, "PAUSED");
+		mvprintw(0, 0, "%-*.*s", view.cols, view.cols, status);
+		if (cfg   .paused) mvprintw(0, view.cols-6, "PAUSED");
 		attroff(COLOR_PAIR(1));
 #endif
 
 #ifdef ENABLE_HOTKEYS
 		if (cfg.paused) {
-			print_menu(width, height);
-			usleep(1);
+			print_menu(view.cols, view.rows);
+			frame_invalidate(&frame);
 		}
 #endif
 		refresh();
+		frame_wait(&due, framerate);
 	}
 
-	free_all(worlds, width, height);
+	free_frame(&frame);
+	free_life(&life);
 	delwin(win);
 	endwin(); /* exit ncurses mode */
 	return (EXIT_SUCCESS);
 }
+#endif
+
+int main(int argc, char * argv[]) {
+	const struct engine * engine = &engines[0];
+	const char * kernels = NULL, * pattern_path = NULL;
+	int threads = 0, world_width = 0, world_height = 0, benchmark = 0, ret;
+	uint64_t generations = BENCH_GENERATIONS, seed = 1;
+	char * end;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "e:W:H:k:t:m:p:bg:s:h")) != -1) {
+		switch (opt) {
+			case 'e':
+				if ((engine = find_engine(optarg)) == NULL) print_usage_and_exit(argv[0]);
+				break;
+			case 'W':
+				if ((world_width = atoi(optarg)) <= 0) print_usage_and_exit(argv[0]);
+				break;
+			case 'H':
+				if ((world_height = atoi(optarg)) <= 0) print_usage_and_exit(argv[0]);
+				break;
+			case 'k':
+				kernels = optarg;
+				if (strcmp(kernels, "scalar") != 0 && strcmp(kernels, "avx2") != 0 && strcmp(kernels, "avx512") != 0) print_usage_and_exit(argv[0]);
+				break;
+			case 't':
+				threads = atoi(optarg);
+				break;
+			case 'm':
+				hl_cache_mb = strtoul(optarg, &end, 10);
+				if (end == optarg || *end != '\0' || optarg[0] == '-' || hl_cache_mb < 1 || hl_cache_mb > (SIZE_MAX >> 20)) print_usage_and_exit(argv[0]);
+				break;
+			case 'p':
+				pattern_path = optarg;
+				break;
+			case 'b':
+				benchmark = 1;
+				break;
+			case 'g':
+				generations = strtoull(optarg, NULL, 10);
+				break;
+			case 's':
+				seed = strtoull(optarg, NULL, 10);
+				break;
+			default:
+				print_usage_and_exit(argv[0]);
+		}
+	}
+#ifdef GOL_HEADLESS
+	benchmark = 1; /* there is nothing else to do without a terminal */
+#endif
+	kernels = select_kernels(kernels);
+	pool_start(threads);
+
+	if (benchmark) {
+		if (world_width == 0) world_width = BENCH_SIZE;
+		if (world_height == 0) world_height = BENCH_SIZE;
+		ret = bench(argv[0], engine, kernels, world_width, world_height, generations, seed, pattern_path);
+	}
+#ifndef GOL_HEADLESS
+	else ret = play(argv[0], engine, world_width, world_height, pattern_path);
+#endif
+
+	pool_stop();
+	return (ret);
+}